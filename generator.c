@@ -0,0 +1,579 @@
+#ifdef _WIN32
+#include <direct.h>
+#define makeFolder(address) _mkdir(address)
+#else
+#include <sys/stat.h>
+#define makeFolder(address) mkdir(address, 0777)
+
+// fopen_s is only provided by the Microsoft C library
+#define fopen_s(fp, address, mode) (*(fp) = fopen(address, mode))
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Writes a synthetic dataset with the layout of the CURE-TSR "Train" folder read by main.c: the 61 sub-folders (ChallengeFree, then each of the 12
+// visual conditions at challenge levels 1 to 5) holding 24-bit BMP files named 01_SS_CC_LL_NNNN.bmp. Each sign type is drawn as its own shape, colors,
+// and symbol over a random background, so a classifier can learn it, and each visual condition changes the same base images the way its name says,
+// more so at higher challenge levels. imageCounts.txt is written next to the sub-folders for main.c to read.
+//
+// usage: generator <dataset folder> [images per sign, or 14 comma separated counts] [smallest image size] [largest image size] [seed]
+
+// sub-folder names for each visual condition; conditions other than ChallengeFree are followed by the challenge level
+char* conditionNames[13] = { "ChallengeFree", "Decolorization", "LensBlur", "CodecError", "Darkening", "DirtyLens", "Exposure", "GaussianBlur",
+	"Noise", "Rain", "Shadow", "Snow", "Haze" };
+
+// images of each sign type written to each sub-folder, limited by the 4 digit image numbers in the file names
+int imageCounts[14] = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100 };
+#define maxImagesPerSign 9999
+
+// range of image widths and heights; main.c can read images of up to 80,000 pixels
+int minSize = 28;
+int maxSize = 64;
+#define largestSize 256
+
+unsigned int baseSeed = 1;
+
+// folder written to, ending with a separator
+char root[256];
+
+// pixel colors of the base image and of the image with a visual condition applied, top row first
+int width;
+int height;
+float baseR[largestSize * largestSize];
+float baseG[largestSize * largestSize];
+float baseB[largestSize * largestSize];
+float r[largestSize * largestSize];
+float g[largestSize * largestSize];
+float b[largestSize * largestSize];
+float blurred[largestSize * largestSize];
+
+// BMP file being written
+unsigned char file[54 + largestSize * (largestSize * 3 + 3)];
+
+// random number stream state
+unsigned int state[4];
+
+// shapes of the signs
+#define circle 0
+#define triangle 1
+#define invertedTriangle 2
+#define octagon 3
+#define diamond 4
+#define square 5
+
+// symbols drawn inside the signs
+#define noSymbol 0
+#define twoBars 1
+#define block 2
+#define twoBlocks 3
+#define cross 4
+#define slash 5
+#define bar 6
+#define ring 7
+#define bump 8
+#define leftArrow 9
+#define rightArrow 10
+#define letterP 11
+
+// colors used by the signs
+float red[3] = { 200.0f, 20.0f, 30.0f };
+float white[3] = { 235.0f, 235.0f, 235.0f };
+float blue[3] = { 20.0f, 60.0f, 180.0f };
+float black[3] = { 20.0f, 20.0f, 20.0f };
+float yellow[3] = { 240.0f, 190.0f, 20.0f };
+
+// shape, border color, inside color, symbol, and symbol color of each sign type, in CURE-TSR order: speed limit, goods vehicles, no overtaking, no
+// stopping, no parking, stop, bicycle, hump, no left, no right, priority to, no entry, yield, parking
+char signShapes[14] = { circle, circle, circle, circle, circle, octagon, circle, triangle, circle, circle, diamond, circle, invertedTriangle, square };
+float* signBorders[14] = { red, red, red, red, red, white, white, red, red, red, white, white, red, white };
+float* signInsides[14] = { white, white, white, blue, blue, red, blue, white, white, white, yellow, red, white, blue };
+char signSymbols[14] = { twoBars, block, twoBlocks, cross, slash, bar, ring, bump, leftArrow, rightArrow, noSymbol, bar, noSymbol, letterP };
+float* symbolColors[14] = { black, black, red, red, red, white, white, black, black, black, black, white, black, white };
+
+// advance the random number stream (xoshiro128**) and return its next 32-bit value
+unsigned int nextRandom() {
+	unsigned int result = state[1] * 5;
+	result = ((result << 7) | (result >> 25)) * 9;
+	unsigned int t = state[1] << 9;
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = (state[3] << 11) | (state[3] >> 21);
+	return result;
+}
+
+// start the random number stream for one image, so each image is the same however many others are written
+void seedRandom(int condition, int challenge, int sign, int number) {
+	unsigned long long x = ((unsigned long long)baseSeed << 32) ^ ((unsigned long long)(((condition * 8 + challenge) * 16 + sign)) << 14) ^ number;
+	unsigned long long z = 0;
+	for (int i = 0; i < 4; i++) {
+		// splitmix64 spreads the seed over the four state words
+		x += 0x9E3779B97F4A7C15ULL;
+		z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		state[i] = (unsigned int)(z >> 32);
+	}
+}
+
+// get a random decimal number with min as the minimum possible value and range as the possible range of values
+float randFloat(float min, float range) {
+	return min + ((float)(nextRandom() >> 8) / 16777216.0f) * range;
+}
+
+// get a random integer with min as the minimun possible value and range as the number of possible values
+int randInt(int min, int range) {
+	return min + (int)(((unsigned long long)nextRandom() * (unsigned int)range) >> 32);
+}
+
+// distance of a point from the center of a shape, scaled so the edge of the shape is at 1
+float shapeDistance(char shape, float u, float v) {
+	float x = fabsf(u);
+	float y = fabsf(v);
+	switch (shape) {
+	case circle: return sqrtf(u * u + v * v);
+	case triangle: return fmaxf(v, 0.866f * x - 0.5f * v) * 2.0f;
+	case invertedTriangle: return fmaxf(-v, 0.866f * x + 0.5f * v) * 2.0f;
+	case octagon: return fmaxf(fmaxf(x, y), (x + y) * 0.7071f);
+	case diamond: return (x + y) * 0.7071f;
+	}
+	return fmaxf(x, y);
+}
+
+// whether a point inside a sign is part of its symbol
+char inSymbol(char symbol, float u, float v) {
+	float d = sqrtf(u * u + v * v);
+	switch (symbol) {
+	case twoBars: return fabsf(v) < 0.35f && fabsf(fabsf(u) - 0.2f) < 0.08f;
+	case block: return fabsf(u) < 0.3f && fabsf(v) < 0.18f;
+	case twoBlocks: return fabsf(v) < 0.15f && fabsf(fabsf(u) - 0.25f) < 0.12f;
+	case cross: return fabsf(u - v) < 0.12f || fabsf(u + v) < 0.12f;
+	case slash: return fabsf(u + v) < 0.12f;
+	case bar: return fabsf(u) < 0.5f && fabsf(v) < 0.12f;
+	case ring: return fabsf(d - 0.35f) < 0.08f;
+	case bump: return v < 0.25f && v > 0.25f - 0.3f * (1.0f - fminf(1.0f, u * u * 6.0f));
+	case leftArrow: return (fabsf(v) < 0.06f && u > -0.35f && u < 0.35f) || (u < -0.1f && fabsf(v) < 0.35f + u);
+	case rightArrow: return (fabsf(v) < 0.06f && u > -0.35f && u < 0.35f) || (u > 0.1f && fabsf(v) < 0.35f - u);
+	case letterP: return (fabsf(u + 0.15f) < 0.08f && fabsf(v) < 0.45f) || (v < 0.0f && fabsf(sqrtf((u + 0.05f) * (u + 0.05f) + (v + 0.22f) * (v + 0.22f)) - 0.2f) < 0.07f && u > -0.1f);
+	}
+	return 0;
+}
+
+// draw the base image of a sign: the sign at a random position and size over a random background, with random lighting
+void drawSign(int sign) {
+	width = randInt(minSize, maxSize - minSize + 1);
+	height = randInt(minSize, maxSize - minSize + 1);
+
+	float backR = randFloat(40.0f, 160.0f);
+	float backG = randFloat(40.0f, 160.0f);
+	float backB = randFloat(40.0f, 160.0f);
+	float slope = randFloat(-1.0f, 2.0f);
+	float light = randFloat(0.7f, 0.45f);
+
+	float size = (float)(width < height ? width : height);
+	float radius = size * randFloat(0.32f, 0.14f);
+	float centerX = (float)width * 0.5f + randFloat(-0.08f, 0.16f) * size;
+	float centerY = (float)height * 0.5f + randFloat(-0.08f, 0.16f) * size;
+
+	float u, v, d, shade;
+	float* color = NULL;
+	int index = 0;
+
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			index = i * width + j;
+			u = ((float)j + 0.5f - centerX) / radius;
+			v = ((float)i + 0.5f - centerY) / radius;
+			d = shapeDistance(signShapes[sign], u, v);
+			if (d > 1.0f) {
+				// background with a gradient and texture
+				shade = 1.0f + 0.3f * slope * ((float)i / (float)height - 0.5f) + randFloat(-0.08f, 0.16f);
+				baseR[index] = backR * shade;
+				baseG[index] = backG * shade;
+				baseB[index] = backB * shade;
+				continue;
+			}
+			if (d > 0.8f) {
+				color = signBorders[sign];
+			}
+			else if (inSymbol(signSymbols[sign], u, v)) {
+				color = symbolColors[sign];
+			}
+			else {
+				color = signInsides[sign];
+			}
+			shade = light * (1.0f + randFloat(-0.04f, 0.08f));
+			baseR[index] = color[0] * shade;
+			baseG[index] = color[1] * shade;
+			baseB[index] = color[2] * shade;
+		}
+	}
+}
+
+// blur one color of the image with a box of the given radius
+void boxBlur(float* a, int radius) {
+	int count = 0;
+	float total = 0.0f;
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			total = 0.0f;
+			count = 0;
+			for (int y = i - radius; y <= i + radius; y++) {
+				for (int x = j - radius; x <= j + radius; x++) {
+					if (y >= 0 && y < height && x >= 0 && x < width) {
+						total += a[y * width + x];
+						count++;
+					}
+				}
+			}
+			blurred[i * width + j] = total / (float)count;
+		}
+	}
+	memcpy(a, blurred, sizeof(float) * width * height);
+}
+
+// darken a disc of the image, as a spot on the lens
+void darkenSpot(float x, float y, float radius, float amount) {
+	float d = 0.0f;
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			d = sqrtf(((float)j - x) * ((float)j - x) + ((float)i - y) * ((float)i - y)) / radius;
+			if (d < 1.0f) {
+				d = 1.0f - amount * (1.0f - d * d);
+				r[i * width + j] *= d;
+				g[i * width + j] *= d;
+				b[i * width + j] *= d;
+			}
+		}
+	}
+}
+
+// copy the base image and apply a visual condition at a challenge level (1 to 5) to it
+void applyCondition(int condition, int challenge) {
+	int numPixels = width * height;
+	float level = (float)challenge / 5.0f;
+	float gray, amount, x, y, dx, dy;
+	int index = 0;
+
+	memcpy(r, baseR, sizeof(float) * numPixels);
+	memcpy(g, baseG, sizeof(float) * numPixels);
+	memcpy(b, baseB, sizeof(float) * numPixels);
+
+	switch (condition) {
+	case 1:
+		// Decolorization: move each pixel toward gray
+		for (int i = 0; i < numPixels; i++) {
+			gray = 0.299f * r[i] + 0.587f * g[i] + 0.114f * b[i];
+			r[i] += (gray - r[i]) * level;
+			g[i] += (gray - g[i]) * level;
+			b[i] += (gray - b[i]) * level;
+		}
+		break;
+	case 2:
+		// LensBlur: one wide box blur
+		boxBlur(r, challenge);
+		boxBlur(g, challenge);
+		boxBlur(b, challenge);
+		break;
+	case 3:
+		// CodecError: flatten blocks of pixels and quantize their colors
+		for (int i = 0; i < height; i += 4) {
+			for (int j = 0; j < width; j += 4) {
+				float totalR = 0.0f, totalG = 0.0f, totalB = 0.0f;
+				int count = 0;
+				for (int y = i; y < i + 4 && y < height; y++) {
+					for (int x = j; x < j + 4 && x < width; x++) {
+						totalR += r[y * width + x];
+						totalG += g[y * width + x];
+						totalB += b[y * width + x];
+						count++;
+					}
+				}
+				for (int y = i; y < i + 4 && y < height; y++) {
+					for (int x = j; x < j + 4 && x < width; x++) {
+						index = y * width + x;
+						r[index] += (totalR / count - r[index]) * level;
+						g[index] += (totalG / count - g[index]) * level;
+						b[index] += (totalB / count - b[index]) * level;
+						r[index] = floorf(r[index] / (8.0f * challenge)) * 8.0f * challenge;
+						g[index] = floorf(g[index] / (8.0f * challenge)) * 8.0f * challenge;
+						b[index] = floorf(b[index] / (8.0f * challenge)) * 8.0f * challenge;
+					}
+				}
+			}
+		}
+		break;
+	case 4:
+		// Darkening
+		for (int i = 0; i < numPixels; i++) {
+			r[i] *= 1.0f - 0.16f * challenge;
+			g[i] *= 1.0f - 0.16f * challenge;
+			b[i] *= 1.0f - 0.16f * challenge;
+		}
+		break;
+	case 5:
+		// DirtyLens: dark spots
+		for (int k = 0; k < challenge; k++) {
+			darkenSpot(randFloat(0.0f, (float)width), randFloat(0.0f, (float)height), randFloat(0.1f, 0.15f) * width, randFloat(0.4f, 0.4f));
+		}
+		break;
+	case 6:
+		// Exposure: move each pixel toward white
+		for (int i = 0; i < numPixels; i++) {
+			r[i] += (255.0f - r[i]) * 0.16f * challenge;
+			g[i] += (255.0f - g[i]) * 0.16f * challenge;
+			b[i] += (255.0f - b[i]) * 0.16f * challenge;
+		}
+		break;
+	case 7:
+		// GaussianBlur: repeated small box blurs
+		for (int k = 0; k < challenge; k++) {
+			boxBlur(r, 1);
+			boxBlur(g, 1);
+			boxBlur(b, 1);
+		}
+		break;
+	case 8:
+		// Noise
+		amount = 16.0f * challenge;
+		for (int i = 0; i < numPixels; i++) {
+			r[i] += randFloat(-amount, 2.0f * amount);
+			g[i] += randFloat(-amount, 2.0f * amount);
+			b[i] += randFloat(-amount, 2.0f * amount);
+		}
+		break;
+	case 9:
+		// Rain: light diagonal streaks
+		for (int k = 0; k < challenge * width / 8 + 1; k++) {
+			x = randFloat(0.0f, (float)width);
+			y = randFloat(-(float)height * 0.5f, (float)height);
+			dx = randFloat(-0.4f, 0.3f);
+			for (int l = 0; l < height / 3; l++) {
+				index = (int)(y + l);
+				int column = (int)(x + dx * l);
+				if (index >= 0 && index < height && column >= 0 && column < width) {
+					index = index * width + column;
+					r[index] += (200.0f - r[index]) * 0.6f;
+					g[index] += (200.0f - g[index]) * 0.6f;
+					b[index] += (210.0f - b[index]) * 0.6f;
+				}
+			}
+		}
+		break;
+	case 10:
+		// Shadow: darken the image on one side of a line
+		x = randFloat(0.2f, 0.6f) * width;
+		dy = randFloat(-1.0f, 2.0f);
+		for (int i = 0; i < height; i++) {
+			for (int j = 0; j < width; j++) {
+				if ((float)j < x + dy * ((float)i - height * 0.5f)) {
+					index = i * width + j;
+					r[index] *= 1.0f - 0.15f * challenge;
+					g[index] *= 1.0f - 0.15f * challenge;
+					b[index] *= 1.0f - 0.15f * challenge;
+				}
+			}
+		}
+		break;
+	case 11:
+		// Snow: white flakes
+		for (int i = 0; i < numPixels; i++) {
+			if (randFloat(0.0f, 1.0f) < 0.03f * challenge) {
+				r[i] = 245.0f;
+				g[i] = 245.0f;
+				b[i] = 250.0f;
+			}
+		}
+		break;
+	case 12:
+		// Haze: move each pixel toward light gray
+		for (int i = 0; i < numPixels; i++) {
+			r[i] += (190.0f - r[i]) * 0.17f * challenge;
+			g[i] += (190.0f - g[i]) * 0.17f * challenge;
+			b[i] += (195.0f - b[i]) * 0.17f * challenge;
+		}
+		break;
+	}
+}
+
+// store a little-endian value in the file being written
+void putValue(int position, unsigned int value, int bytes) {
+	for (int i = 0; i < bytes; i++) {
+		file[position + i] = (unsigned char)(value >> (8 * i));
+	}
+}
+
+// limit a color value to 0 to 255
+unsigned char toByte(float value) {
+	if (value < 0.0f) {
+		return 0;
+	}
+	if (value > 255.0f) {
+		return 255;
+	}
+	return (unsigned char)(value + 0.5f);
+}
+
+// write the current image as a 24-bit BMP file, bottom row first, each row padded to a multiple of 4 bytes
+char writeImage(char* address) {
+	int lineLength = width * 3 + (width % 4);
+	int size = 54 + lineLength * height;
+	memset(file, 0, size);
+
+	file[0] = 'B';
+	file[1] = 'M';
+	putValue(2, size, 4);
+	putValue(10, 54, 4);
+	putValue(14, 40, 4);
+	putValue(18, width, 4);
+	putValue(22, height, 4);
+	putValue(26, 1, 2);
+	putValue(28, 24, 2);
+	putValue(34, lineLength * height, 4);
+	putValue(38, 2835, 4);
+	putValue(42, 2835, 4);
+
+	int index = 0;
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			index = (height - i - 1) * width + j;
+			file[54 + i * lineLength + j * 3] = toByte(b[index]);
+			file[54 + i * lineLength + j * 3 + 1] = toByte(g[index]);
+			file[54 + i * lineLength + j * 3 + 2] = toByte(r[index]);
+		}
+	}
+
+	FILE* fp;
+	fopen_s(&fp, address, "wb");
+	if (fp == NULL) {
+		printf("Couldn't write file %s\n", address);
+		return 0;
+	}
+	fwrite(file, 1, size, fp);
+	fclose(fp);
+	return 1;
+}
+
+// get the folder of a visual condition and challenge level (0 for ChallengeFree)
+char* getFolder(int condition, int challenge) {
+	static char address[512];
+	if (condition == 0) {
+		snprintf(address, sizeof(address), "%s%s", root, conditionNames[0]);
+	}
+	else {
+		snprintf(address, sizeof(address), "%s%s-%i", root, conditionNames[condition], challenge);
+	}
+	return address;
+}
+
+// read the image counts argument: one count for every sign type, or 14 comma separated counts
+char readCounts(char* text) {
+	for (int i = 0; i < 14; i++) {
+		imageCounts[i] = (int)strtol(text, &text, 10);
+		if (imageCounts[i] < 1 || imageCounts[i] > maxImagesPerSign) {
+			return 0;
+		}
+		if (*text == ',') {
+			text++;
+		}
+		else if (i == 0 && *text == 0) {
+			for (int j = 1; j < 14; j++) {
+				imageCounts[j] = imageCounts[0];
+			}
+			return 1;
+		}
+		else if (*text != 0 || i != 13) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printf("usage: generator <dataset folder> [images per sign, or 14 comma separated counts] [smallest image size] [largest image size] [seed]\n");
+		return 1;
+	}
+
+	// the dataset folder gets a separator at the end, as datasetRoot in main.c has
+	snprintf(root, sizeof(root) - 1, "%s", argv[1]);
+	char separator = strchr(root, '\\') != NULL && strchr(root, '/') == NULL ? '\\' : '/';
+	int length = (int)strlen(root);
+	if (length > 0 && root[length - 1] != separator) {
+		root[length] = separator;
+		root[length + 1] = 0;
+	}
+
+	if (argc > 2 && !readCounts(argv[2])) {
+		printf("Image counts must be from 1 to %i\n", maxImagesPerSign);
+		return 1;
+	}
+	if (argc > 3) {
+		minSize = atoi(argv[3]);
+	}
+	if (argc > 4) {
+		maxSize = atoi(argv[4]);
+	}
+	if (argc > 5) {
+		baseSeed = (unsigned int)strtoul(argv[5], NULL, 10);
+	}
+	if (minSize < 8 || maxSize > largestSize || minSize > maxSize) {
+		printf("Image sizes must be from 8 to %i\n", largestSize);
+		return 1;
+	}
+	makeFolder(root);
+	for (int condition = 0; condition < 13; condition++) {
+		for (int challenge = condition == 0 ? 0 : 1; challenge <= (condition == 0 ? 0 : 5); challenge++) {
+			makeFolder(getFolder(condition, challenge));
+		}
+	}
+
+	char address[600];
+	char* folder = NULL;
+	long long written = 0;
+	long long bytes = 0;
+
+	// each sign image is drawn once and written to every sub-folder with the visual condition applied
+	for (int sign = 1; sign <= 14; sign++) {
+		for (int number = 1; number <= imageCounts[sign - 1]; number++) {
+			seedRandom(0, 0, sign, number);
+			drawSign(sign - 1);
+
+			for (int condition = 0; condition < 13; condition++) {
+				for (int challenge = condition == 0 ? 0 : 1; challenge <= (condition == 0 ? 0 : 5); challenge++) {
+					seedRandom(condition, challenge, sign, number);
+					applyCondition(condition, challenge);
+					folder = getFolder(condition, challenge);
+					snprintf(address, sizeof(address), "%s%c01_%02i_%02i_%02i_%04i.bmp", folder, separator, sign, condition, challenge, number);
+					if (!writeImage(address)) {
+						return 1;
+					}
+					written++;
+					bytes += 54 + (width * 3 + (width % 4)) * height;
+				}
+			}
+		}
+		printf("Sign type %i done\n", sign);
+	}
+
+	snprintf(address, sizeof(address), "%simageCounts.txt", root);
+	FILE* fp;
+	fopen_s(&fp, address, "w");
+	if (fp == NULL) {
+		printf("Couldn't write file %s\n", address);
+		return 1;
+	}
+	for (int i = 0; i < 14; i++) {
+		fprintf(fp, "%i%c", imageCounts[i], i < 13 ? ' ' : '\n');
+	}
+	fclose(fp);
+
+	printf("Wrote %lld images (%lld bytes) to %s\n", written, bytes, root);
+	return 0;
+}
@@ -1,23 +1,86 @@
+#ifdef __linux__
+// needed for syscall, used to read the hardware counters, and for the CPU affinity functions used to place threads
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
+#include <string.h>
+
+// threads and atomic operations, used to convolve one image on several cores
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#define atomicAdd(p, value) InterlockedExchangeAdd((volatile LONG*)(p), (value))
+#define atomicLoad(p) InterlockedOr((volatile LONG*)(p), 0)
+#define atomicStore(p, value) InterlockedExchange((volatile LONG*)(p), (value))
+#define threadLocal __declspec(thread)
+#else
+#include <pthread.h>
+#include <sched.h>
+#define atomicAdd(p, value) __atomic_fetch_add((p), (value), __ATOMIC_ACQ_REL)
+#define atomicLoad(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define atomicStore(p, value) __atomic_store_n((p), (value), __ATOMIC_RELEASE)
+#define threadLocal _Thread_local
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// fopen_s is only provided by the Microsoft C library
+#define fopen_s(fp, address, mode) (*(fp) = fopen(address, mode))
+#endif
+
+// keep multiplications and additions separate instead of fusing them (fused multiply-add), which compilers may do differently in each convolution
+// kernel when building for processors that have it, rounding the same sums differently; with other compilers, build with the equivalent of
+// gcc -ffp-contract=off
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
 
 int imageCounts[14] = { 1087, 290, 85, 38, 807, 89, 1091, 206, 104, 193, 80, 116, 626, 2478 };
 // most folders have 2480 parking signs, yet LensBlur-1, Darkening-1, and GaussianBlur-1 have 2478, thus, 2478 is used
+// a dataset written by generator.c replaces these with the counts in its imageCounts.txt
+
+// folder holding the 61 sub-folders, ending with the separator used between folders and files
+char datasetRoot[256] = "C:\\Train\\";
 
-// number of images
+// set to 1 to read the images straight from the CURE-TSR archives in archiveRoot (ChallengeFree.zip, CodecError-1.zip, and so on) instead of the
+// extracted sub-folders; archiveRoot ends with the separator used between folders and files
+char readArchives = 0;
+char archiveRoot[256] = "C:\\CURE-TSR\\Real_Train\\";
+
+// number of images; numPerSign can be set when compiling (for example gcc -DnumPerSign=380) to sample more images from a generated dataset
+#ifndef numPerSign
 #define numPerSign 38 // per sign within each folder
-#define numPerFolder 532 // within each folder
-#define numPerCondition 2660 // per visual condition
-#define numTotal 32452 // in sample
-#define numWithChallenges 31920 // in sample excluding ChallengeFree sub-folder
-#define numTraining 24339 // in training set, 3/4 of total sample
+#endif
+#define numPerFolder (numPerSign * 14) // within each folder
+#define numPerCondition (numPerFolder * 5) // per visual condition
+#define numTotal (numPerFolder * 61) // in sample
+#define numWithChallenges (numPerFolder * 60) // in sample excluding ChallengeFree sub-folder
+#define numTraining (numTotal * 3 / 4) // in training set, 3/4 of total sample
+
+// largest number of images of one sign in one folder, limited by the 4 digit image numbers in the file names
+#define maxImagesPerSign 9999
 
 // image file address being used
-char* currentAddress = NULL;
+char currentAddress[512];
 
 // images left of each sign within each folder to choose from for randomization
-char imagesLeft[2500];
+char imagesLeft[maxImagesPerSign];
+
+// tree of the numbers of sample images not yet placed in the randomized order, used to find the one chosen at each step
+int imagesUnplaced[numTotal + 1];
 
 // properties of sampled images before randomization
 char orderedConditions[numTotal];
@@ -36,15 +99,228 @@ int imageNumbers[numTotal];
 int numFilters = 0;
 int numFiltersPerColor = 0;
 
-// convolutional filters
-#define maxFilterArea 121
-float filter[maxNumFilters][maxFilterArea];
+// largest convolutional filter size supported (odd); can be set with -DmaxFilterSize=n, and unrolled convolution kernels are generated for sizes up to 15
+#ifndef maxFilterSize
+#define maxFilterSize 15
+#endif
+#if maxFilterSize > 15
+#error "maxFilterSize above 15 has no unrolled convolution kernel"
+#endif
+#define maxFilterArea (maxFilterSize * maxFilterSize)
+
+// range of filter sizes used in the experiment
+#define firstFilterSize 3
+#define lastFilterSize 11
+
+// number of configurations (filter size, filter count, and color model) in the experiment
+#define numConfigurations (((lastFilterSize - firstFilterSize) / 2 + 1) * 4 * 8)
+
+// stages measured for each trial (convolve, computeNN, and train) and hardware counters read around them (cycles, instructions, cache misses, and
+// branch misses)
+#define numStages 3
+#define numCounters 4
+
+// state of one trial: its configuration, the parameters it trains, and its results
+typedef struct Trial {
+	char filterSize;
+	int numFilters;
+	char colorModel;
+
+	// convolutional filters, neural network weights and biases, and totals of the neural network inputs over the training images. When
+	// parameterPrecision is not 0, the filters and weights are replaced by their 16-bit values once training is done (the stored arrays), which are
+	// written over the first half of the 32-bit arrays' memory, so no other memory is used for them
+	union {
+		float filter[maxNumFilters][maxFilterArea];
+		unsigned short storedFilter[maxNumFilters][maxFilterArea];
+	};
+	union {
+		float nnWeights1[maxNumFilters][maxNumFilters];
+		unsigned short storedWeights1[maxNumFilters][maxNumFilters];
+	};
+	union {
+		float nnWeights2[14][maxNumFilters];
+		unsigned short storedWeights2[14][maxNumFilters];
+	};
+	float nnBiases1[maxNumFilters];
+	float nnBiases2[14];
+	float nnInputTotals[maxNumFilters];
+
+	// number of images trained on so far, and for early stopping, whether training has stopped, the best validation accuracy so far (%), and the
+	// number of validations since it last improved; imagesTrained also counts the images skipped as too large, which are counted in imagesSkipped
+	// and left out of the neural network input averages
+	int imagesTrained;
+	int imagesSkipped;
+	char stopped;
+	float bestValidation;
+	int validationsWithoutImprovement;
+
+	// accuracy on the validation images when last measured (%), the number of validation images classified, and with successive halving, the round
+	// after which the trial was left out (0 if it was not)
+	float validation;
+	int imagesValidated;
+	int eliminated;
+
+	// for sequential testing, why testing stopped (0 if it did not) and the confidence interval of the accuracy (%)
+	char testingStopped;
+	float accuracyLow;
+	float accuracyHigh;
+
+	// with stage measurement, the time (milliseconds), hardware counter totals, and analytic floating-point operation and byte counts of each stage
+	double stageTime[numStages];
+	long long stageCounters[numStages][numCounters];
+	double stageFlops[numStages];
+	double stageBytes[numStages];
+
+	// whether the filters and weights have been replaced by their 16-bit values
+	char stored;
+
+	// weights left after magnitude pruning, by row: the weights, the column of each, and where each row starts
+	float prunedWeights1[maxNumFilters * maxNumFilters];
+	unsigned char prunedColumns1[maxNumFilters * maxNumFilters];
+	int prunedRows1[maxNumFilters + 1];
+	float prunedWeights2[14 * maxNumFilters];
+	unsigned char prunedColumns2[14 * maxNumFilters];
+	int prunedRows2[14 + 1];
+	char pruned;
+
+	// with pruning, the forward passes through the dense and the pruned weights made on the test images, their total active middle layer values, and
+	// their total time (milliseconds)
+	int passesDense;
+	int passesPruned;
+	long long activeDense;
+	long long activePruned;
+	double nnTimeDense;
+	double nnTimePruned;
+
+	// with warmStart, the filter count of the model the trial started from (0 if none), the number of images that model was trained on, and the
+	// number that model and the ones it started from in turn were trained on in all
+	int warmStartFilters;
+	int warmStartImages;
+	int warmStartChain;
+
+	// stats for testing, durations in milliseconds
+	int imagesCorrect;
+	int imagesClassified;
+	double timeTraining;
+	double timeTesting;
+	int memoryUsage;
+} Trial;
+
+// trials being run, either one at a time or as a group of trials stepped through the images together
+#define maxTrialsPerGroup 40
+Trial trials[maxTrialsPerGroup];
+
+// set to 1 to run the 8 color model trials of each filter size and filter count together, reading each image once for all of them;
+// set to 2 to also run every filter size together, so each image is read once for all 40 trials of each filter count
+char trialGroups = 0;
+
+// set to 1 to hold out the last numValidation training images, measure accuracy on them every validationInterval training images, and stop training
+// a trial once its validation accuracy has not improved by at least earlyStoppingMargin percentage points for earlyStoppingPatience validations in a row
+char earlyStopping = 0;
+int numValidation = 1000;
+int validationInterval = 2000;
+float earlyStoppingMargin = 0.5f;
+int earlyStoppingPatience = 2;
+
+// set to 1 to search the configurations by successive halving instead of running all of them to completion: every trial trains on the first
+// halvingBudget training images and is measured on the numValidation held out images, the most accurate 1/halvingRate of them continue on halvingRate
+// times as many images, and so on until the trials left train on the whole training set and are tested
+char successiveHalving = 0;
+int halvingBudget = 1500;
+int halvingRate = 3;
+
+// set to 1 to save the state of every trial to halvingCheckpoint after each round of successive halving, and resume from it if it is there
+char halvingCheckpoints = 0;
+char halvingCheckpoint[] = "halving.chk";
+
+// set to 1 to save each trial's parameters to model-<size>-<filters>-<color model>.bin in the working folder once it is trained; set warmStart to 1
+// to also start each trial from the saved model with the most filters below its own, for the same filter size and color model, instead of only
+// random values (see warmStartTrial); models are saved with warmStart as well, so the smaller trials of a run start the larger ones
+char saveModels = 0;
+char warmStart = 0;
+#define modelMagic 0x4d435356
+#define modelHeaderSize 15
+
+// set to 1 to add a line with the configuration and results of each tested trial to resultsFile in the working folder
+char saveResults = 0;
+char resultsFile[] = "results.csv";
+
+// set to 1 to choose the model to serve instead of running the trials: the configurations in resultsFile with saved models are tried from the most
+// accurate down, for the same parameterPrecision and pruneFraction, each timed classifying the first selectionImages test images on this computer from
+// reading each image to its prediction after an untimed pass over them, and the first whose 99th percentile time per image is within latencyBudget milliseconds and whose memory usage is within memoryBudget bytes is written to
+// servingModel, with its latency distribution in servingReport
+char selectModel = 0;
+double latencyBudget = 2.0;
+int memoryBudget = 2000000;
+#define selectionImages 500
+char servingModel[] = "serving-model.bin";
+char servingReport[] = "serving-model.txt";
+
+// set to 1 to stop testing a trial once the confidence interval of its accuracy is narrower than targetIntervalWidth percentage points, or once it is
+// certain to be less accurate than the best trial finished so far. The interval is only checked after minTestImages test images, twice that, four
+// times that, and so on, and after the last test image; the error allowed by confidenceLevel is split equally between these checks, so the intervals
+// of every check hold together with at least that confidence and stopping at any of them keeps it
+char sequentialTesting = 0;
+float targetIntervalWidth = 4.0f;
+float confidenceLevel = 0.95f;
+int minTestImages = 200;
+
+// standard deviations used by the intervals of each check, set for the number of checks by prepareSequentialChecks
+float checkZ = 1.96f;
+
+// highest lower bound of the accuracy of any trial finished so far, used by sequential testing
+float bestAccuracyLow = 0.0f;
+
+// set to 1 to measure the time of each stage of each trial, read the hardware counters around it where the system allows (Linux perf events), and
+// report the achieved GFLOP/s, arithmetic intensity, and instructions per cycle of each stage
+char measureStages = 0;
+
+// precision the filters and weights are stored in for testing: 0 for 32-bit floats, 1 for 16-bit half precision floats (fp16), 2 for bfloat16;
+// training always uses the 32-bit parameters
+char parameterPrecision = 0;
+char* precisionNames[3] = { "fp32", "fp16", "bf16" };
+
+// fraction of each neural network layer's weights to remove by magnitude once training is done, testing with the rest in a sparse format; 0 to keep all
+float pruneFraction = 0.0f;
+
+// convolution kernels: the unrolled kernels, the loops over the filter used for any filter size, and a kernel computing whole rows of the feature map
+// from the image as floats; all of them add the same terms in the same order, without fused multiply-adds
+#define numKernels 3
+char* kernelNames[numKernels] = { "unrolled", "generic", "rows" };
+
+// set to 1 to time the kernels for each filter size, filter count, and number of colors before the trials and use the fastest, unless its results
+// on the timing image differ from the unrolled kernels'; the choices are kept in a tuning file for this computer, so later runs skip the timing
+char tuneKernels = 0;
+
+// kernel chosen for each filter size, filter count, and number of colors (-1 until chosen), and the kernel used for the current trial
+char kernelChoices[maxFilterSize + 1][maxNumFilters + 1][5];
+char kernel = 0;
+
+// set while the current trial is tested with its 16-bit parameters
+char useStoredParameters = 0;
+
+// selected filter converted to 32 bits, used with 16-bit parameters
+threadLocal float loadedFilter[maxFilterArea];
+
+// trial being trained or tested
+Trial* currentTrial = &trials[0];
+
+// set while the current image is used to train the current trial
+char training = 0;
+
+// convolutional filters of the current trial
+float (*filter)[maxFilterArea] = trials[0].filter;
 
 // selected filter during feature extraction
-float* F;
+threadLocal float* F;
 
-// selected filter number during feature extraction
-int f;
+// where the maximum of the feature map being computed and its position are kept, and the rows of the feature map computed; each thread convolving
+// an image has its own, so the filters (and row bands) can be computed at the same time
+threadLocal float* mapMax;
+threadLocal int* mapMaxI;
+threadLocal int* mapMaxJ;
+threadLocal int rowStart;
+threadLocal int rowEnd;
 
 // i-value (height) and j-value (width) of the maximum value on the feature map, used for training
 int filterMapMaxI[maxNumFilters];
@@ -52,25 +328,28 @@ int filterMapMaxJ[maxNumFilters];
 
 // maximum values on the feature maps, used as the neural network input for each filter
 float nnInputs[maxNumFilters];
-float nnInputTotals[maxNumFilters];
+float* nnInputTotals = trials[0].nnInputTotals;
 
 // neural network weight values used to compute the outputs given the inputs
-float nnWeights1[maxNumFilters][maxNumFilters];
-float nnWeights2[14][maxNumFilters];
+float (*nnWeights1)[maxNumFilters] = trials[0].nnWeights1;
+float (*nnWeights2)[maxNumFilters] = trials[0].nnWeights2;
 
 // neural network bias values used to compute the outputs given the inputs
-float nnBiases1[maxNumFilters];
-float nnBiases2[14];
+float* nnBiases1 = trials[0].nnBiases1;
+float* nnBiases2 = trials[0].nnBiases2;
 
 // values in middle layer of neural network
 float nnHidden[maxNumFilters];
 
+// middle layer values that are above 0 after the last computeNN, which are the only ones the output layer and its training use
+int nnActive[maxNumFilters];
+int numActive = 0;
+
 // predictive values for each traffic sign type, outputted by the neural network
 float nnOutputs[14];
 
-// width, height, and number of pixels of the selected image
-int innerWidth;
-int innerHeight;
+// width, height, and number of pixels of the selected image; the color arrays hold the image without padding, and the pixel after the last one
+// (index numPixels) is black and stands in for the area surrounding the image, so after conversion it holds each color's value there
 int width;
 int height;
 int numPixels;
@@ -78,13 +357,20 @@ int lineLength;
 
 // convolutional filter size
 char filterSize;
-char filterArea;
-char halfFilterArea;
+int filterArea;
+int halfFilterArea;
 char padding;
-char doublePadding;
 
 #define maxImageSize 80000
 
+// optional resolution normalization: resample each image to targetWidth by targetHeight after reading it, before conversion
+char resizeImages = 0;
+int targetWidth = 32;
+int targetHeight = 32;
+
+// filter used to resample images: 0 for area (box average), 1 for bilinear
+char resizeFilter = 0;
+
 // image pixel colors
 unsigned char r[maxImageSize];
 unsigned char g[maxImageSize];
@@ -95,50 +381,164 @@ unsigned char c2[maxImageSize];
 unsigned char c3[maxImageSize];
 unsigned char c4[maxImageSize];
 
+// number of times the converted pixel color arrays have been filled, so the rows kernel knows when to convert them to floats again
+int planeVersion = 0;
+
+// resampled pixel colors, used while resizing an image
+unsigned char resizedR[maxImageSize];
+unsigned char resizedG[maxImageSize];
+unsigned char resizedB[maxImageSize];
+
 char currentColorModel = 0;
 
-// stats for testing
-int imageNumber = 0;
-int imagesCorrect = 0;
-int imagesClassified = 0;
-int timeTraining = 0;
-int timeTesting = 0;
-int timeTotal = 0;
+// seed the whole experiment is reproduced from; the image sample and each trial use their own stream derived from it
+unsigned int baseSeed = 1;
+#define sampleStream 0xFFFFFFFFu
+
+// random number stream states for the image sample and for the current trial
+unsigned int sampleRandom[4];
+unsigned int trialRandom[4];
 
-// memory usage measured during each test
-int memoryUsage = 0;
+// number of the image being classified
+int imageNumber = 0;
 
 // data from image files stored as a text string
 #define maxFileSize 240000
 unsigned char file[maxFileSize];
 
-// clock start and stop millisecond values used for timing
-int start;
-int stop;
+// sub-folder names for each visual condition; conditions other than ChallengeFree are followed by the challenge level
+char* conditionNames[13] = { "ChallengeFree", "Decolorization", "LensBlur", "CodecError", "Darkening", "DirtyLens", "Exposure", "GaussianBlur",
+	"Noise", "Rain", "Shadow", "Snow", "Haze" };
+
+// advance a random number stream (xoshiro128**) and return its next 32-bit value
+unsigned int nextRandom(unsigned int* s) {
+	unsigned int result = s[1] * 5;
+	result = ((result << 7) | (result >> 25)) * 9;
+	unsigned int t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 11) | (s[3] >> 21);
+	return result;
+}
+
+// start a random number stream determined only by the base seed and the stream (trial) number, so each trial is reproducible on its own
+void seedRandom(unsigned int* s, unsigned int seed, unsigned int stream) {
+	unsigned long long x = ((unsigned long long)seed << 32) | stream;
+	unsigned long long z = 0;
+	for (int i = 0; i < 4; i++) {
+		// splitmix64 spreads the seed over the four state words
+		x += 0x9E3779B97F4A7C15ULL;
+		z = x;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		s[i] = (unsigned int)(z >> 32);
+	}
+}
+
+// get a random decimal number with min as the minimum possible value and range as the possible range of values
+float randFloat(unsigned int* s, float min, float range) {
+	return min + ((float)(nextRandom(s) >> 8) / 16777216.0f) * range;
+}
+
+// get a random integer with min as the minimun possible value and range as the number of possible values
+int randInt(unsigned int* s, int min, int range) {
+	return min + (int)(((unsigned long long)nextRandom(s) * (unsigned int)range) >> 32);
+}
+
+// get the current time in milliseconds, used for timing
+double getMilliseconds() {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+// convert a 32-bit float to a 16-bit half precision float, rounding to the nearest value
+unsigned short floatToHalf(float value) {
+	union { float f; unsigned int u; } v;
+	v.f = value;
+	unsigned int sign = (v.u >> 16) & 0x8000;
+	int exponent = (int)((v.u >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = v.u & 0x7FFFFF;
+
+	if (exponent >= 31) {
+		// too large (or infinite or NaN)
+		return (unsigned short)(sign | 0x7C00 | (((v.u >> 23) & 0xFF) == 0xFF && mantissa ? 0x200 : 0));
+	}
+	if (exponent <= 0) {
+		// subnormal or too small
+		if (exponent < -10) {
+			return (unsigned short)sign;
+		}
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - exponent);
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int midpoint = 1u << (shift - 1);
+		if (rest > midpoint || (rest == midpoint && (half & 1))) {
+			half++;
+		}
+		return (unsigned short)(sign | half);
+	}
+	unsigned int half = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		// rounding may carry into the exponent, which is still correct
+		half++;
+	}
+	return (unsigned short)half;
+}
+
+// convert a 16-bit half precision float to a 32-bit float
+float halfToFloat(unsigned short value) {
+	union { float f; unsigned int u; } v;
+	unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+	unsigned int exponent = (value >> 10) & 0x1F;
+	unsigned int mantissa = value & 0x3FF;
+
+	if (exponent == 0) {
+		// zero or subnormal
+		v.f = (float)mantissa / 16777216.0f;
+		v.u |= sign;
+		return v.f;
+	}
+	if (exponent == 31) {
+		v.u = sign | 0x7F800000 | (mantissa << 13);
+		return v.f;
+	}
+	v.u = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	return v.f;
+}
+
+// convert a 32-bit float to a bfloat16 (the upper 16 bits of a 32-bit float), rounding to the nearest value
+unsigned short floatToBfloat(float value) {
+	union { float f; unsigned int u; } v;
+	v.f = value;
+	if ((v.u & 0x7F800000) == 0x7F800000) {
+		return (unsigned short)((v.u >> 16) | ((v.u & 0x7FFFFF) ? 0x40 : 0));
+	}
+	v.u += 0x7FFF + ((v.u >> 16) & 1);
+	return (unsigned short)(v.u >> 16);
+}
 
-// file address templates
-char a0[] = "C:\\Train\\ChallengeFree\\01_  _  _  _    .bmp";
-char a1[] = "C:\\Train\\Decolorization- \\01_  _  _  _    .bmp";
-char a2[] = "C:\\Train\\LensBlur- \\01_  _  _  _    .bmp";
-char a3[] = "C:\\Train\\CodecError- \\01_  _  _  _    .bmp";
-char a4[] = "C:\\Train\\Darkening- \\01_  _  _  _    .bmp";
-char a5[] = "C:\\Train\\DirtyLens- \\01_  _  _  _    .bmp";
-char a6[] = "C:\\Train\\Exposure- \\01_  _  _  _    .bmp";
-char a7[] = "C:\\Train\\GaussianBlur- \\01_  _  _  _    .bmp";
-char a8[] = "C:\\Train\\Noise- \\01_  _  _  _    .bmp";
-char a9[] = "C:\\Train\\Rain- \\01_  _  _  _    .bmp";
-char a10[] = "C:\\Train\\Shadow- \\01_  _  _  _    .bmp";
-char a11[] = "C:\\Train\\Snow- \\01_  _  _  _    .bmp";
-char a12[] = "C:\\Train\\Haze- \\01_  _  _  _    .bmp";
+// convert a bfloat16 to a 32-bit float
+float bfloatToFloat(unsigned short value) {
+	union { float f; unsigned int u; } v;
+	v.u = (unsigned int)value << 16;
+	return v.f;
+}
 
-// get a random decimal number with av as the mean value and range as the possible range of values
-float randFloat(float min, float range) {
-	return min + (((float)rand()) / 32768.0f) * range;
+// convert a parameter to the 16-bit storage precision being used
+unsigned short storeParameter(float value) {
+	return parameterPrecision == 1 ? floatToHalf(value) : floatToBfloat(value);
 }
 
-// get a random decimal number with min as the minimun possible value and range as the possible range of values
-int randInt(int min, int range) {
-	return min + (((unsigned int)rand()) % range);
+// convert a parameter from the 16-bit storage precision being used
+float loadParameter(unsigned short value) {
+	return parameterPrecision == 1 ? halfToFloat(value) : bfloatToFloat(value);
 }
 
 // fill arrays with zeros
@@ -196,6 +596,17 @@ char getNumColors() {
 	return 3;
 }
 
+// get the number of the current trial within the experiment from its filter size, filter count, and color model
+unsigned int getTrialNumber() {
+	return (((filterSize - firstFilterSize) / 2) * 4 + (numFilters / 24 - 1)) * 8 + currentColorModel;
+}
+
+// get the random number stream of the current trial from its filter size, filter count, and color model alone, not their place in the sweep, so a
+// configuration starts from the same parameters whichever range of filter sizes a run covers
+unsigned int getTrialStream() {
+	return ((filterSize / 2 - 1) * 4 + (numFilters / 24 - 1)) * 8 + currentColorModel;
+}
+
 // selects 32,452 random images as the training and testing sample
 void initializeImages() {
 
@@ -213,9 +624,11 @@ void initializeImages() {
 		orderedSigns[i] = ((i / numPerSign) % 14) + 1;
 	}
 
+	seedRandom(sampleRandom, baseSeed, sampleStream);
+
 	int added = 0;
 	// randomly choose images within each sign in each sub-folder
-	for (int i = 0; i < 854; i++) {
+	for (int i = 0; i < 61 * 14; i++) {
 		added = i * numPerSign;
 		count = imageCounts[i % 14];
 		for (int j = 0; j < count; j++) {
@@ -223,9 +636,9 @@ void initializeImages() {
 		}
 
 		for (int j = 0; j < numPerSign; j++) {
-			r = randInt(1, count);
+			r = randInt(sampleRandom, 1, count);
 			while (imagesLeft[r - 1]) {
-				r = randInt(1, count);
+				r = randInt(sampleRandom, 1, count);
 			}
 
 			imagesLeft[r - 1] = 1;
@@ -235,26 +648,48 @@ void initializeImages() {
 
 	numImagesLeft = numTotal;
 
+	// each image starts unplaced; the tree holds the number of unplaced images in ranges of the ordered sample, so the image chosen from those
+	// left is found without moving the rest, which keeps large generated samples fast
+	for (int i = 1; i <= numTotal; i++) {
+		imagesUnplaced[i] = i & -i;
+	}
+	int top = 1;
+	while (top * 2 <= numTotal) {
+		top *= 2;
+	}
+
 	// arrange the sample images in random order
+	int k = 0;
 	for (int i = 0; i < numTotal; i++) {
-		r = randInt(0, numImagesLeft);
-		imageConditions[i] = orderedConditions[r];
-		imageChallenges[i] = orderedChallenges[r];
-		imageSigns[i] = orderedSigns[r];
-		imageNumbers[i] = orderedNumbers[r];
+		r = randInt(sampleRandom, 0, numImagesLeft);
+
+		// find the (r + 1)th unplaced image and mark it placed
+		k = 0;
+		for (int step = top; step > 0; step /= 2) {
+			if (k + step <= numTotal && imagesUnplaced[k + step] <= r) {
+				k += step;
+				r -= imagesUnplaced[k];
+			}
+		}
+		for (int j = k + 1; j <= numTotal; j += j & -j) {
+			imagesUnplaced[j]--;
+		}
 
+		imageConditions[i] = orderedConditions[k];
+		imageChallenges[i] = orderedChallenges[k];
+		imageSigns[i] = orderedSigns[k];
+		imageNumbers[i] = orderedNumbers[k];
 		numImagesLeft--;
-		for (int j = r; j < numImagesLeft; j++) {
-			orderedConditions[j] = orderedConditions[j + 1];
-			orderedChallenges[j] = orderedChallenges[j + 1];
-			orderedSigns[j] = orderedSigns[j + 1];
-			orderedNumbers[j] = orderedNumbers[j + 1];
-		}
 	}
 }
 
+// sample of images used, set by the function that initializes it: 0 for all visual conditions, 1 for challenge-free images only, 2 for challenge
+// level 1 only
+char imageSelection = 0;
+
 // use all image visual conditions as the sample
 void initializeImagesAll() {
+	imageSelection = 0;
 	for (int i = 0; i < numWithChallenges; i++) {
 		orderedConditions[i + numPerFolder] = (i / numPerCondition) + 1;
 		orderedChallenges[i + numPerFolder] = ((i / numPerFolder) % 5) + 1;
@@ -264,6 +699,7 @@ void initializeImagesAll() {
 
 // use only challenge-free images as the sample
 void initializeImagesChallengeFree() {
+	imageSelection = 1;
 	for (int i = 0; i < numWithChallenges; i++) {
 		orderedConditions[i + numPerFolder] = 0;
 		orderedChallenges[i + numPerFolder] = 0;
@@ -273,6 +709,7 @@ void initializeImagesChallengeFree() {
 
 // use only challenge level 1 for images with challenge levels in the sample
 void initializeImagesLowChallenge() {
+	imageSelection = 2;
 	for (int i = 0; i < numWithChallenges; i++) {
 		orderedConditions[i + numPerFolder] = (i / numPerCondition) + 1;
 		orderedChallenges[i + numPerFolder] = 1;
@@ -280,58 +717,41 @@ void initializeImagesLowChallenge() {
 	initializeImages();
 }
 
-// modify one of the file address templates above for one particular image
-char* modifyAddress(char* a, char s, char condition, char challenge, char sign, int number) {
-	a[s - 5] = challenge + 48;
-	a[s] = (sign / 10) + 48;
-	a[s + 1] = (sign % 10) + 48;
-	a[s + 3] = (condition / 10) + 48;
-	a[s + 4] = (condition % 10) + 48;
-	a[s + 6] = (challenge / 10) + 48;
-	a[s + 7] = (challenge % 10) + 48;
-	a[s + 9] = (number / 1000) + 48;
-	a[s + 10] = ((number / 100) % 10) + 48;
-	a[s + 11] = ((number / 10) % 10) + 48;
-	a[s + 12] = (number % 10) + 48;
-	return a;
-}
-
 // create the image file address from the visual condition, challenge level, sign type, and image number
 char* getAddress(char condition, char challenge, char sign, int number) {
+	char separator = datasetRoot[strlen(datasetRoot) - 1];
 
 	if (condition == 0) {
-		challenge = 0;
+		snprintf(currentAddress, sizeof(currentAddress), "%s%s%c01_%02i_00_00_%04i.bmp", datasetRoot, conditionNames[0], separator, sign, number);
+	}
+	else {
+		snprintf(currentAddress, sizeof(currentAddress), "%s%s-%i%c01_%02i_%02i_%02i_%04i.bmp", datasetRoot, conditionNames[(int)condition], challenge,
+		separator, sign, condition, challenge, number);
+	}
+	return currentAddress;
+}
+
+// read the number of images of each sign in each folder from imageCounts.txt in the dataset folder, if there is one, as written by generator.c
+void readImageCounts() {
+	char address[512];
+	int counts[14];
+	FILE* fp;
+	snprintf(address, sizeof(address), "%simageCounts.txt", datasetRoot);
+	fopen_s(&fp, address, "r");
+	if (fp == NULL) {
+		return;
+	}
+	for (int i = 0; i < 14; i++) {
+		if (fscanf(fp, "%i", &counts[i]) != 1 || counts[i] < numPerSign || counts[i] > maxImagesPerSign) {
+			printf("%s must hold 14 image counts from %i to %i; using the CURE-TSR counts\n", address, numPerSign, maxImagesPerSign);
+			fclose(fp);
+			return;
+		}
+	}
+	fclose(fp);
+	for (int i = 0; i < 14; i++) {
+		imageCounts[i] = counts[i];
 	}
-	
-	switch (condition) {
-	case 0:
-	{
-		a0[26] = (sign / 10) + 48;
-		a0[26 + 1] = (sign % 10) + 48;
-		a0[26 + 3] = (condition / 10) + 48;
-		a0[26 + 4] = (condition % 10) + 48;
-		a0[26 + 6] = (challenge / 10) + 48;
-		a0[26 + 7] = (challenge % 10) + 48;
-		a0[26 + 9] = (number / 1000) + 48;
-		a0[26 + 10] = ((number / 100) % 10) + 48;
-		a0[26 + 11] = ((number / 10) % 10) + 48;
-		a0[26 + 12] = (number % 10) + 48;
-		return a0;
-	}
-	case 1: return modifyAddress(a1, 29, condition, challenge, sign, number);
-	case 2: return modifyAddress(a2, 23, condition, challenge, sign, number);
-	case 3: return modifyAddress(a3, 25, condition, challenge, sign, number);
-	case 4: return modifyAddress(a4, 24, condition, challenge, sign, number);
-	case 5: return modifyAddress(a5, 24, condition, challenge, sign, number);
-	case 6: return modifyAddress(a6, 23, condition, challenge, sign, number);
-	case 7: return modifyAddress(a7, 27, condition, challenge, sign, number);
-	case 8: return modifyAddress(a8, 20, condition, challenge, sign, number);
-	case 9: return modifyAddress(a9, 19, condition, challenge, sign, number);
-	case 10: return modifyAddress(a10, 21, condition, challenge, sign, number);
-	case 11: return modifyAddress(a11, 19, condition, challenge, sign, number);
-	case 12: return modifyAddress(a12, 19, condition, challenge, sign, number);
-	}
-	return (char*)0;
 }
 
 // convert RGB pixel color array to another color model
@@ -343,11 +763,13 @@ void convert() {
 	float delta = 0.0f;
 	int sum = 0;
 
+	planeVersion++;
+
 	switch (currentColorModel) {
 	case 0:
 	case 1:
 		// For RGB, set c1 to R, set c2 to G, set c3 to B; for RGBK, set c4 to calculated K values
-		for (int i = 0; i < numPixels; i++) {
+		for (int i = 0; i <= numPixels; i++) {
 
 			c1[i] = r[i];
 			c2[i] = g[i];
@@ -364,7 +786,7 @@ void convert() {
 	case 2:
 	case 3:
 		// For CMY, set c1 to calculated C values, set c2 to calculated M values, set c3 to calculated Y values; for CMYK, set c4 to calculated K values
-		for (int i = 0; i < numPixels; i++) {
+		for (int i = 0; i <= numPixels; i++) {
 
 			max = r[i];
 			if (g[i] > max) { max = g[i]; }
@@ -380,7 +802,7 @@ void convert() {
 	case 4:
 	case 5:
 		// For HSV, set c1 to calculated H values, set c2 to calculated S values, set c3 to calculated V values; for HSL, set c3 to calculated L values
-		for (int i = 0; i < numPixels; i++) {
+		for (int i = 0; i <= numPixels; i++) {
 
 			max = r[i];
 			if (g[i] > max) { max = g[i]; }
@@ -418,7 +840,7 @@ void convert() {
 	case 6:
 	case 7:
 		// For K grayscale, set c1 to calculated K values; for L grayscale, set c1 to calculated L values
-		for (int i = 0; i < numPixels; i++) {
+		for (int i = 0; i <= numPixels; i++) {
 
 			max = r[i];
 			if (g[i] > max) { max = g[i]; }
@@ -440,7 +862,47 @@ void convert() {
 	}
 }
 
-// read an image file given the image's file address, constructing RGB arrays for the image with padding and filling them with the pixel color data
+// set by decodeFile when the image just read is too large for the arrays, and by readArchive when it cannot be read from its archive; training,
+// validation, and testing leave such images out
+char imageSkipped = 0;
+
+// construct RGB arrays for the image file in the file array, given its address, and fill them with the pixel color data; the arrays do not depend
+// on the filter size, since the convolution treats the area around the image as black
+void decodeFile(char* address) {
+
+	// reading width and height
+	width = file[18] | (file[19] << 8) | (file[20] << 16) | (file[21] << 24);
+	height = file[22] | (file[23] << 8) | (file[24] << 16) | (file[25] << 24);
+
+	// images too large for the arrays are skipped (left empty); the sizes are multiplied in 64 bits so large headers cannot overflow. The unrolled
+	// kernels read up to maxFilterSize / 2 values past the last pixel at the right edge (with 0 filter values), so that much room is kept after it
+	imageSkipped = 0;
+	if (width <= 0 || height <= 0 || width >= maxImageSize || height >= maxImageSize || (long long)width * height + maxFilterSize / 2 >= maxImageSize
+		|| 54 + ((long long)width * 3 + width % 4) * height > maxFileSize) {
+		printf("Image %s is too large (%ix%i)\n", address, width, height);
+		width = 0;
+		height = 0;
+		imageSkipped = 1;
+	}
+	lineLength = width * 3 + (width % 4);
+
+	numPixels = width * height;
+
+	// structuring the color data into three arrays (RGB); transferring each pixel color value from the string of text from the file to these arrays
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			r[(height - i - 1) * width + j] = file[i * lineLength + j * 3 + 56];
+			g[(height - i - 1) * width + j] = file[i * lineLength + j * 3 + 55];
+			b[(height - i - 1) * width + j] = file[i * lineLength + j * 3 + 54];
+		}
+	}
+
+	r[numPixels] = 0;
+	g[numPixels] = 0;
+	b[numPixels] = 0;
+}
+
+// read an image file given the image's file address into the file array and fill the RGB arrays from it
 void readFile(char* address) {
 
 	FILE* fp;
@@ -452,373 +914,1678 @@ void readFile(char* address) {
 		fread(file, sizeof(char), maxFileSize, fp);
 		fclose(fp);
 	}
+	decodeFile(address);
+}
 
-	// reading width and height
-	innerWidth = file[18];
-	innerHeight = file[22];
-	width = innerWidth + doublePadding;
-	height = innerHeight + doublePadding;
-
-	numPixels = width * height;
-
-	lineLength = innerWidth * 3 + (innerWidth % 4);
-
-	// structuring the color data into three arrays (RGB); transferring each pixel color value from the string of text from the file to these arrays
-	for (int i = 0; i < innerHeight; i++) {
-		for (int j = 0; j < innerWidth; j++) {
-			r[(height - i - padding - 1) * width + j + padding] = file[i * lineLength + j * 3 + 56];
-			g[(height - i - padding - 1) * width + j + padding] = file[i * lineLength + j * 3 + 55];
-			b[(height - i - padding - 1) * width + j + padding] = file[i * lineLength + j * 3 + 54];
+// an image stored in an archive: its sign type and image number (as sign * 10000 + number), where its local header starts, how it is compressed
+// (0 for stored, 8 for deflate), and its compressed and uncompressed sizes
+typedef struct ArchiveEntry {
+	int key;
+	unsigned int offset;
+	int method;
+	unsigned int compressedSize;
+	unsigned int size;
+} ArchiveEntry;
+
+// an open archive of one of the 61 folders and the index of its images, sorted by key, built once from its central directory
+typedef struct Archive {
+	FILE* fp;
+	ArchiveEntry* entries;
+	int numEntries;
+	char indexed;
+} Archive;
+Archive archives[61];
+
+// compressed data of the archive entry being read; deflate data is read from it bit by bit, starting with the least significant bit of each byte
+unsigned char archiveData[maxFileSize];
+int inflateSize;
+int inflatePosition;
+unsigned int bitBuffer;
+int bitCount;
+char inflateError;
+
+// canonical Huffman code of deflate: the number of codes of each length and the symbols ordered by code
+typedef struct Huffman {
+	short counts[16];
+	short symbols[288];
+} Huffman;
+
+// base values and extra bits of the deflate length and distance symbols
+short lengthBases[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+char lengthExtras[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+short distanceBases[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193,
+12289, 16385, 24577 };
+char distanceExtras[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// order in which the lengths of the code length code are stored
+char codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// read a little-endian 16-bit or 32-bit value
+#define read16(p) ((unsigned int)(p)[0] | ((unsigned int)(p)[1] << 8))
+#define read32(p) (read16(p) | (read16((p) + 2) << 16))
+
+// take the next n bits of the compressed data
+int getBits(int n) {
+	int value = 0;
+	while (bitCount < n) {
+		if (inflatePosition >= inflateSize) {
+			inflateError = 1;
+			return 0;
 		}
+		bitBuffer |= (unsigned int)archiveData[inflatePosition] << bitCount;
+		inflatePosition++;
+		bitCount += 8;
 	}
+	value = bitBuffer & ((1u << n) - 1);
+	bitBuffer >>= n;
+	bitCount -= n;
+	return value;
+}
 
-	// surrounding the pixel color data with 0s as padding for use in feature extraction
-	for (int p = 0; p < padding; p++) {
-		for (int i = 1; i <= height; i++) {
-			r[(i - 1) * width + p] = 0;
-			g[(i - 1) * width + p] = 0;
-			b[(i - 1) * width + p] = 0;
-			r[i * width - 1 - p] = 0;
-			g[i * width - 1 - p] = 0;
-			b[i * width - 1 - p] = 0;
+// build the canonical Huffman code for n symbols with the given code lengths; returns -1 if the lengths describe more codes than can exist
+int buildHuffman(Huffman* h, unsigned char* lengths, int n) {
+	short offsets[16];
+	int left = 1;
+	for (int length = 0; length < 16; length++) {
+		h->counts[length] = 0;
+	}
+	for (int s = 0; s < n; s++) {
+		h->counts[lengths[s]]++;
+	}
+	for (int length = 1; length < 16; length++) {
+		left = left * 2 - h->counts[length];
+		if (left < 0) {
+			return -1;
 		}
-		for (int i = 0; i < width; i++) {
-			r[p * width + i] = 0;
-			g[p * width + i] = 0;
-			b[p * width + i] = 0;
-			r[(height - 1 - p) * width + i] = 0;
-			g[(height - 1 - p) * width + i] = 0;
-			b[(height - 1 - p) * width + i] = 0;
+	}
+	offsets[1] = 0;
+	for (int length = 1; length < 15; length++) {
+		offsets[length + 1] = offsets[length] + h->counts[length];
+	}
+	for (int s = 0; s < n; s++) {
+		if (lengths[s] != 0) {
+			h->symbols[offsets[lengths[s]]] = s;
+			offsets[lengths[s]]++;
 		}
 	}
+	return 0;
 }
 
-// fill all convolutional filters, neural network weights, and neural network biases with values prior to training in each trial
-void randomizeParameters() {
-	for (int i = 0; i < maxNumFilters; i++) {
-		for (int j = 0; j < maxFilterArea; j++) {
-			filter[i][j] = randFloat(-5.0f, 10.0f);
+// decode the next symbol of the compressed data with a Huffman code, one bit at a time; returns -1 if no code matches
+int decodeSymbol(Huffman* h) {
+	int code = 0;
+	int first = 0;
+	int index = 0;
+	for (int length = 1; length < 16; length++) {
+		code |= getBits(1);
+		if (code - h->counts[length] < first) {
+			return h->symbols[index + code - first];
 		}
-		for (int j = 0; j < maxNumFilters; j++) {
-			nnWeights1[j][i] = randFloat(-0.5f, 1.0f);
+		index += h->counts[length];
+		first = (first + h->counts[length]) << 1;
+		code <<= 1;
+	}
+	inflateError = 1;
+	return -1;
+}
+
+// read the code lengths of a dynamic Huffman block and build its literal/length and distance codes; returns -1 if they are invalid
+int readDynamicCodes(Huffman* literals, Huffman* distances) {
+	unsigned char lengths[320];
+	Huffman codeLengths;
+	int numLiterals = getBits(5) + 257;
+	int numDistances = getBits(5) + 1;
+	int numCodeLengths = getBits(4) + 4;
+	int symbol = 0;
+	int repeat = 0;
+	int n = 0;
+
+	if (numLiterals > 286 || numDistances > 30) {
+		return -1;
+	}
+	for (int k = 0; k < 19; k++) {
+		lengths[(int)codeLengthOrder[k]] = k < numCodeLengths ? getBits(3) : 0;
+	}
+	if (buildHuffman(&codeLengths, lengths, 19) < 0) {
+		return -1;
+	}
+	while (n < numLiterals + numDistances) {
+		symbol = decodeSymbol(&codeLengths);
+		if (symbol < 0 || inflateError) {
+			return -1;
 		}
-		for (int j = 0; j < 14; j++) {
-			nnWeights2[j][i] = randFloat(-0.5f, 1.0f);
+		if (symbol < 16) {
+			lengths[n] = symbol;
+			n++;
+			continue;
+		}
+		// 16 repeats the previous length 3 to 6 times, 17 and 18 repeat zero 3 to 10 and 11 to 138 times
+		if (symbol == 16) {
+			if (n == 0) {
+				return -1;
+			}
+			symbol = lengths[n - 1];
+			repeat = 3 + getBits(2);
+		}
+		else if (symbol == 17) {
+			symbol = 0;
+			repeat = 3 + getBits(3);
+		}
+		else {
+			symbol = 0;
+			repeat = 11 + getBits(7);
+		}
+		if (n + repeat > numLiterals + numDistances) {
+			return -1;
+		}
+		while (repeat > 0) {
+			lengths[n] = symbol;
+			n++;
+			repeat--;
 		}
-		nnBiases1[i] = 0.0f;
 	}
-	for (int i = 0; i < 14; i++) {
-		nnBiases2[i] = 0.0f;
+	if (lengths[256] == 0) {
+		return -1;
 	}
-	for (int i = 0; i < maxNumFilters; i++) {
-		nnInputTotals[i] = 0.0f;
+	if (buildHuffman(literals, lengths, numLiterals) < 0 || buildHuffman(distances, lengths + numLiterals, numDistances) < 0) {
+		return -1;
 	}
+	return 0;
 }
 
-// compute feature map for one convolutional filter and one image pixel color array
-void convolveColor(unsigned char* a) {
-	float total = 0;
-	switch (filterSize) {
-	case 3:
-		for (int i = 1; i < height - 1; i++) {
-			for (int j = 1; j < width - 1; j++) {
-				total = F[0] * (float)a[(i - 1) * width + j - 1] + F[1] * (float)a[(i - 1) * width + j] + F[2] * (float)a[(i - 1) * width + j + 1] +
-				F[3] * (float)a[i * width + j - 1] + F[4] * (float)a[i * width + j] + F[5] * (float)a[i * width + j + 1] +
-				F[6] * (float)a[(i + 1) * width + j - 1] + F[7] * (float)a[(i + 1) * width + j] + F[8] * (float)a[(i + 1) * width + j + 1];
-				if (total > nnInputs[f]) {
-					nnInputs[f] = total;
-					filterMapMaxI[f] = i;
-					filterMapMaxJ[f] = j;
-				}
+// decompress size bytes of deflate data from archiveData into file; returns the number of bytes written, or -1 if the data is invalid or
+// decompresses to more than maxFileSize bytes
+int inflateEntry(int size) {
+	unsigned char lengths[320];
+	Huffman literals;
+	Huffman distances;
+	int out = 0;
+	int last = 0;
+	int type = 0;
+	int symbol = 0;
+	int length = 0;
+	int distance = 0;
+
+	inflateSize = size;
+	inflatePosition = 0;
+	bitBuffer = 0;
+	bitCount = 0;
+	inflateError = 0;
+
+	do {
+		last = getBits(1);
+		type = getBits(2);
+		if (type == 0) {
+			// stored block: skip to the next byte, then copy the number of bytes given
+			bitBuffer = 0;
+			bitCount = 0;
+			if (inflatePosition + 4 > inflateSize) {
+				return -1;
+			}
+			length = read16(archiveData + inflatePosition);
+			if ((length ^ 0xffff) != (int)read16(archiveData + inflatePosition + 2)) {
+				return -1;
 			}
+			inflatePosition += 4;
+			if (inflatePosition + length > inflateSize || out + length > maxFileSize) {
+				return -1;
+			}
+			memcpy(file + out, archiveData + inflatePosition, length);
+			inflatePosition += length;
+			out += length;
+			continue;
 		}
-		break;
-	case 5:
-		for (int i = 2; i < height - 2; i++) {
-			for (int j = 2; j < width - 2; j++) {
-				total = F[0] * (float)a[(i - 2) * width + j - 2] + F[1] * (float)a[(i - 2) * width + j - 1] + F[2] * (float)a[(i - 2) * width + j] +
-				F[3] * (float)a[(i - 2) * width + j + 1] + F[4] * (float)a[(i - 2) * width + j + 2] + F[5] * (float)a[(i - 1) * width + j - 2] +
-				F[6] * (float)a[(i - 1) * width + j - 1] + F[7] * (float)a[(i - 1) * width + j] + F[8] * (float)a[(i - 1) * width + j + 1] +
-				F[9] * (float)a[(i - 1) * width + j + 2] + F[10] * (float)a[i * width + j - 2] + F[11] * (float)a[i * width + j - 1] +
-				F[12] * (float)a[i * width + j] + F[13] * (float)a[i * width + j + 1] + F[14] * (float)a[i * width + j + 2] +
-				F[15] * (float)a[(i + 1) * width + j - 2] + F[16] * (float)a[(i + 1) * width + j - 1] + F[17] * (float)a[(i + 1) * width + j] +
-				F[18] * (float)a[(i + 1) * width + j + 1] + F[19] * (float)a[(i + 1) * width + j + 2] + F[20] * (float)a[(i + 2) * width + j - 2] +
-				F[21] * (float)a[(i + 2) * width + j - 1] + F[22] * (float)a[(i + 2) * width + j] + F[23] * (float)a[(i + 2) * width + j + 1] +
-				F[24] * (float)a[(i + 2) * width + j + 2];
-				if (total > nnInputs[f]) {
-					nnInputs[f] = total;
-					filterMapMaxI[f] = i;
-					filterMapMaxJ[f] = j;
-				}
+		if (type == 1) {
+			// fixed Huffman codes
+			for (int s = 0; s < 288; s++) {
+				lengths[s] = s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8;
 			}
+			buildHuffman(&literals, lengths, 288);
+			for (int s = 0; s < 30; s++) {
+				lengths[s] = 5;
+			}
+			buildHuffman(&distances, lengths, 30);
 		}
-		break;
-	case 7:
-		for (int i = 3; i < height - 3; i++) {
-			for (int j = 3; j < width - 3; j++) {
-				total = F[0] * (float)a[(i - 3) * width + j - 3] + F[1] * (float)a[(i - 3) * width + j - 2] + F[2] * (float)a[(i - 3) * width + j - 1] +
-					F[3] * (float)a[(i - 3) * width + j] + F[4] * (float)a[(i - 3) * width + j + 1] + F[5] * (float)a[(i - 3) * width + j + 2] +
-					F[6] * (float)a[(i - 3) * width + j + 3] + F[7] * (float)a[(i - 2) * width + j - 3] + F[8] * (float)a[(i - 2) * width + j - 2] +
-					F[9] * (float)a[(i - 2) * width + j - 1] + F[10] * (float)a[(i - 2) * width + j] + F[11] * (float)a[(i - 2) * width + j + 1] +
-					F[12] * (float)a[(i - 2) * width + j + 2] + F[13] * (float)a[(i - 2) * width + j + 3] + F[14] * (float)a[(i - 1) * width + j - 3] +
-					F[15] * (float)a[(i - 1) * width + j - 2] + F[16] * (float)a[(i - 1) * width + j - 1] + F[17] * (float)a[(i - 1) * width + j] +
-					F[18] * (float)a[(i - 1) * width + j + 1] + F[19] * (float)a[(i - 1) * width + j + 2] + F[20] * (float)a[(i - 1) * width + j + 3] +
-					F[21] * (float)a[i * width + j - 3] + F[22] * (float)a[i * width + j - 2] + F[23] * (float)a[i * width + j - 1] +
-					F[24] * (float)a[i * width + j] + F[25] * (float)a[i * width + j + 1] + F[26] * (float)a[i * width + j + 2] +
-					F[27] * (float)a[i * width + j + 3] + F[28] * (float)a[(i + 1) * width + j - 3] + F[29] * (float)a[(i + 1) * width + j - 2] +
-					F[30] * (float)a[(i + 1) * width + j - 1] + F[31] * (float)a[(i + 1) * width + j] + F[32] * (float)a[(i + 1) * width + j + 1] +
-					F[33] * (float)a[(i + 1) * width + j + 2] + F[34] * (float)a[(i + 1) * width + j + 3] + F[35] * (float)a[(i + 2) * width + j - 3] +
-					F[36] * (float)a[(i + 2) * width + j - 2] + F[37] * (float)a[(i + 2) * width + j - 1] + F[38] * (float)a[(i + 2) * width + j] +
-					F[39] * (float)a[(i + 2) * width + j + 1] + F[40] * (float)a[(i + 2) * width + j + 2] + F[41] * (float)a[(i + 2) * width + j + 3] +
-					F[42] * (float)a[(i + 3) * width + j - 3] + F[43] * (float)a[(i + 3) * width + j - 2] + F[44] * (float)a[(i + 3) * width + j - 1] +
-					F[45] * (float)a[(i + 3) * width + j] + F[46] * (float)a[(i + 3) * width + j + 1] + F[47] * (float)a[(i + 3) * width + j + 2] +
-					F[48] * (float)a[(i + 3) * width + j + 3];
-				if (total > nnInputs[f]) {
-					nnInputs[f] = total;
-					filterMapMaxI[f] = i;
-					filterMapMaxJ[f] = j;
-				}
+		else if (type == 2) {
+			if (readDynamicCodes(&literals, &distances) < 0) {
+				return -1;
 			}
 		}
-		break;
-	case 9:
-		for (int i = 4; i < height - 4; i++) {
-			for (int j = 4; j < width - 4; j++) {
-				total = F[0] * (float)a[(i - 4) * width + j - 4] + F[1] * (float)a[(i - 4) * width + j - 3] + F[2] * (float)a[(i - 4) * width + j - 2] +
-					F[3] * (float)a[(i - 4) * width + j - 1] + F[4] * (float)a[(i - 4) * width + j] + F[5] * (float)a[(i - 4) * width + j + 1] +
-					F[6] * (float)a[(i - 4) * width + j + 2] + F[7] * (float)a[(i - 4) * width + j + 3] + F[8] * (float)a[(i - 4) * width + j + 4] +
-					F[9] * (float)a[(i - 3) * width + j - 4] + F[10] * (float)a[(i - 3) * width + j - 3] + F[11] * (float)a[(i - 3) * width + j - 2] +
-					F[12] * (float)a[(i - 3) * width + j - 1] + F[13] * (float)a[(i - 3) * width + j] + F[14] * (float)a[(i - 3) * width + j + 1] +
-					F[15] * (float)a[(i - 3) * width + j + 2] + F[16] * (float)a[(i - 3) * width + j + 3] + F[17] * (float)a[(i - 3) * width + j + 4] +
-					F[18] * (float)a[(i - 2) * width + j - 4] + F[19] * (float)a[(i - 2) * width + j - 3] + F[20] * (float)a[(i - 2) * width + j - 2] +
-					F[21] * (float)a[(i - 2) * width + j - 1] + F[22] * (float)a[(i - 2) * width + j] + F[23] * (float)a[(i - 2) * width + j + 1] +
-					F[24] * (float)a[(i - 2) * width + j + 2] + F[25] * (float)a[(i - 2) * width + j + 3] + F[26] * (float)a[(i - 2) * width + j + 4] +
-					F[27] * (float)a[(i - 1) * width + j - 4] + F[28] * (float)a[(i - 1) * width + j - 3] + F[29] * (float)a[(i - 1) * width + j - 2] +
-					F[30] * (float)a[(i - 1) * width + j - 1] + F[31] * (float)a[(i - 1) * width + j] + F[32] * (float)a[(i - 1) * width + j + 1] +
-					F[33] * (float)a[(i - 1) * width + j + 2] + F[34] * (float)a[(i - 1) * width + j + 3] + F[35] * (float)a[(i - 1) * width + j + 4] +
-					F[36] * (float)a[i * width + j - 4] + F[37] * (float)a[i * width + j - 3] + F[38] * (float)a[i * width + j - 2] +
-					F[39] * (float)a[i * width + j - 1] + F[40] * (float)a[i * width + j] + F[41] * (float)a[i * width + j + 1] +
-					F[42] * (float)a[i * width + j + 2] + F[43] * (float)a[i * width + j + 3] + F[44] * (float)a[i * width + j + 4] +
-					F[45] * (float)a[(i + 1) * width + j - 4] + F[46] * (float)a[(i + 1) * width + j - 3] + F[47] * (float)a[(i + 1) * width + j - 2] +
-					F[48] * (float)a[(i + 1) * width + j - 1] + F[49] * (float)a[(i + 1) * width + j] + F[50] * (float)a[(i + 1) * width + j + 1] +
-					F[51] * (float)a[(i + 1) * width + j + 2] + F[52] * (float)a[(i + 1) * width + j + 3] + F[53] * (float)a[(i + 1) * width + j + 4] +
-					F[54] * (float)a[(i + 2) * width + j - 4] + F[55] * (float)a[(i + 2) * width + j - 3] + F[56] * (float)a[(i + 2) * width + j - 2] +
-					F[57] * (float)a[(i + 2) * width + j - 1] + F[58] * (float)a[(i + 2) * width + j] + F[59] * (float)a[(i + 2) * width + j + 1] +
-					F[60] * (float)a[(i + 2) * width + j + 2] + F[61] * (float)a[(i + 2) * width + j + 3] + F[62] * (float)a[(i + 2) * width + j + 4] +
-					F[63] * (float)a[(i + 3) * width + j - 4] + F[64] * (float)a[(i + 3) * width + j - 3] + F[65] * (float)a[(i + 3) * width + j - 2] +
-					F[66] * (float)a[(i + 3) * width + j - 1] + F[67] * (float)a[(i + 3) * width + j] + F[68] * (float)a[(i + 3) * width + j + 1] +
-					F[69] * (float)a[(i + 3) * width + j + 2] + F[70] * (float)a[(i + 3) * width + j + 3] + F[71] * (float)a[(i + 3) * width + j + 4] +
-					F[72] * (float)a[(i + 4) * width + j - 4] + F[73] * (float)a[(i + 4) * width + j - 3] + F[74] * (float)a[(i + 4) * width + j - 2] +
-					F[75] * (float)a[(i + 4) * width + j - 1] + F[76] * (float)a[(i + 4) * width + j] + F[77] * (float)a[(i + 4) * width + j + 1] +
-					F[78] * (float)a[(i + 4) * width + j + 2] + F[79] * (float)a[(i + 4) * width + j + 3] + F[80] * (float)a[(i + 4) * width + j + 4];
-				if (total > nnInputs[f]) {
-					nnInputs[f] = total;
-					filterMapMaxI[f] = i;
-					filterMapMaxJ[f] = j;
+		else {
+			return -1;
+		}
+
+		// literal bytes, and lengths and distances of earlier bytes to copy, until the end of the block
+		while (1) {
+			symbol = decodeSymbol(&literals);
+			if (symbol < 0 || inflateError) {
+				return -1;
+			}
+			if (symbol < 256) {
+				if (out >= maxFileSize) {
+					return -1;
 				}
+				file[out] = symbol;
+				out++;
 			}
-		}
-		break;
-	case 11:
-		for (int i = 5; i < height - 5; i++) {
-			for (int j = 5; j < width - 5; j++) {
-				total = F[0] * (float)a[(i - 5) * width + j - 5] + F[1] * (float)a[(i - 5) * width + j - 4] + F[2] * (float)a[(i - 5) * width + j - 3] +
-					F[3] * (float)a[(i - 5) * width + j - 2] + F[4] * (float)a[(i - 5) * width + j - 1] + F[5] * (float)a[(i - 5) * width + j] +
-					F[6] * (float)a[(i - 5) * width + j + 1] + F[7] * (float)a[(i - 5) * width + j + 2] + F[8] * (float)a[(i - 5) * width + j + 3] +
-					F[9] * (float)a[(i - 5) * width + j + 4] + F[10] * (float)a[(i - 5) * width + j + 5] + F[11] * (float)a[(i - 4) * width + j - 5] +
-					F[12] * (float)a[(i - 4) * width + j - 4] + F[13] * (float)a[(i - 4) * width + j - 3] + F[14] * (float)a[(i - 4) * width + j - 2] +
-					F[15] * (float)a[(i - 4) * width + j - 1] + F[16] * (float)a[(i - 4) * width + j] + F[17] * (float)a[(i - 4) * width + j + 1] +
-					F[18] * (float)a[(i - 4) * width + j + 2] + F[19] * (float)a[(i - 4) * width + j + 3] + F[20] * (float)a[(i - 4) * width + j + 4] +
-					F[21] * (float)a[(i - 4) * width + j + 5] + F[22] * (float)a[(i - 3) * width + j - 5] + F[23] * (float)a[(i - 3) * width + j - 4] +
-					F[24] * (float)a[(i - 3) * width + j - 3] + F[25] * (float)a[(i - 3) * width + j - 2] + F[26] * (float)a[(i - 3) * width + j - 1] +
-					F[27] * (float)a[(i - 3) * width + j] + F[28] * (float)a[(i - 3) * width + j + 1] + F[29] * (float)a[(i - 3) * width + j + 2] +
-					F[30] * (float)a[(i - 3) * width + j + 3] + F[31] * (float)a[(i - 3) * width + j + 4] + F[32] * (float)a[(i - 3) * width + j + 5] +
-					F[33] * (float)a[(i - 2) * width + j - 5] + F[34] * (float)a[(i - 2) * width + j - 4] + F[35] * (float)a[(i - 2) * width + j - 3] +
-					F[36] * (float)a[(i - 2) * width + j - 2] + F[37] * (float)a[(i - 2) * width + j - 1] + F[38] * (float)a[(i - 2) * width + j] +
-					F[39] * (float)a[(i - 2) * width + j + 1] + F[40] * (float)a[(i - 2) * width + j + 2] + F[41] * (float)a[(i - 2) * width + j + 3] +
-					F[42] * (float)a[(i - 2) * width + j + 4] + F[43] * (float)a[(i - 2) * width + j + 5] + F[44] * (float)a[(i - 1) * width + j - 5] +
-					F[45] * (float)a[(i - 1) * width + j - 4] + F[46] * (float)a[(i - 1) * width + j - 3] + F[47] * (float)a[(i - 1) * width + j - 2] +
-					F[48] * (float)a[(i - 1) * width + j - 1] + F[49] * (float)a[(i - 1) * width + j] + F[50] * (float)a[(i - 1) * width + j + 1] +
-					F[51] * (float)a[(i - 1) * width + j + 2] + F[52] * (float)a[(i - 1) * width + j + 3] + F[53] * (float)a[(i - 1) * width + j + 4] +
-					F[54] * (float)a[(i - 1) * width + j + 5] + F[55] * (float)(float)a[i * width + j - 5] + F[56] * (float)a[i * width + j - 4] +
-					F[57] * (float)a[i * width + j - 3] + F[58] * (float)a[i * width + j - 2] + F[59] * (float)a[i * width + j - 1] +
-					F[60] * (float)a[i * width + j] + F[61] * (float)a[i * width + j + 1] + F[62] * (float)a[i * width + j + 2] +
-					F[63] * (float)a[i * width + j + 3] + F[64] * (float)a[i * width + j + 4] + F[65] * (float)a[i * width + j + 5] +
-					F[66] * (float)a[(i + 1) * width + j - 5] + F[67] * (float)a[(i + 1) * width + j - 4] + F[68] * (float)a[(i + 1) * width + j - 3] +
-					F[69] * (float)a[(i + 1) * width + j - 2] + F[70] * (float)a[(i + 1) * width + j - 1] + F[71] * (float)a[(i + 1) * width + j] +
-					F[72] * (float)a[(i + 1) * width + j + 1] + F[73] * (float)a[(i + 1) * width + j + 2] + F[74] * (float)a[(i + 1) * width + j + 3] +
-					F[75] * (float)a[(i + 1) * width + j + 4] + F[76] * (float)a[(i + 1) * width + j + 5] + F[77] * (float)a[(i + 2) * width + j - 5] +
-					F[78] * (float)a[(i + 2) * width + j - 4] + F[79] * (float)a[(i + 2) * width + j - 3] + F[80] * (float)a[(i + 2) * width + j - 2] +
-					F[81] * (float)a[(i + 2) * width + j - 1] + F[82] * (float)a[(i + 2) * width + j] + F[83] * (float)a[(i + 2) * width + j + 1] +
-					F[84] * (float)a[(i + 2) * width + j + 2] + F[85] * (float)a[(i + 2) * width + j + 3] + F[86] * (float)a[(i + 2) * width + j + 4] +
-					F[87] * (float)a[(i + 2) * width + j + 5] + F[88] * (float)a[(i + 3) * width + j - 5] + F[89] * (float)a[(i + 3) * width + j - 4] +
-					F[90] * (float)a[(i + 3) * width + j - 3] + F[91] * (float)a[(i + 3) * width + j - 2] + F[92] * (float)a[(i + 3) * width + j - 1] +
-					F[93] * (float)a[(i + 3) * width + j] + F[94] * (float)a[(i + 3) * width + j + 1] + F[95] * (float)a[(i + 3) * width + j + 2] +
-					F[96] * (float)a[(i + 3) * width + j + 3] + F[97] * (float)a[(i + 3) * width + j + 4] + F[98] * (float)a[(i + 3) * width + j + 5] +
-					F[99] * (float)a[(i + 4) * width + j - 5] + F[100] * (float)a[(i + 4) * width + j - 4] + F[101] * (float)a[(i + 4) * width + j - 3] +
-					F[102] * (float)a[(i + 4) * width + j - 2] + F[103] * (float)a[(i + 4) * width + j - 1] + F[104] * (float)a[(i + 4) * width + j] +
-					F[105] * (float)a[(i + 4) * width + j + 1] + F[106] * (float)a[(i + 4) * width + j + 2] + F[107] * (float)a[(i + 4) * width + j + 3] +
-					F[108] * (float)a[(i + 4) * width + j + 4] + F[109] * (float)a[(i + 4) * width + j + 5] + F[110] * (float)a[(i + 5) * width + j - 5] +
-					F[111] * (float)a[(i + 5) * width + j - 4] + F[112] * (float)a[(i + 5) * width + j - 3] + F[113] * (float)a[(i + 5) * width + j - 2] +
-					F[114] * (float)a[(i + 5) * width + j - 1] + F[115] * (float)a[(i + 5) * width + j] + F[116] * (float)a[(i + 5) * width + j + 1] +
-					F[117] * (float)a[(i + 5) * width + j + 2] + F[118] * (float)a[(i + 5) * width + j + 3] + F[119] * (float)a[(i + 5) * width + j + 4] +
-					F[120] * (float)a[(i + 5) * width + j + 5];
-				if (total > nnInputs[f]) {
-					nnInputs[f] = total;
-					filterMapMaxI[f] = i;
-					filterMapMaxJ[f] = j;
+			else if (symbol == 256) {
+				break;
+			}
+			else {
+				symbol -= 257;
+				if (symbol >= 29) {
+					return -1;
+				}
+				length = lengthBases[symbol] + getBits(lengthExtras[symbol]);
+				symbol = decodeSymbol(&distances);
+				if (symbol < 0 || symbol >= 30) {
+					return -1;
+				}
+				distance = distanceBases[symbol] + getBits(distanceExtras[symbol]);
+				if (inflateError || distance > out || out + length > maxFileSize) {
+					return -1;
+				}
+				for (int k = 0; k < length; k++) {
+					file[out] = file[out - distance];
+					out++;
 				}
 			}
 		}
-		break;
-	}
+	} while (!last);
+	return inflateError ? -1 : out;
 }
 
-// compute feature map for all convolutional filters and the 1 image pixel color array, used for K grayscale and L grayscale
-void convolve1() {
-	int prev = 0;
-	for (f = 0; f < numFilters; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c1);
-	}
+// order of archive entries by key
+int compareEntries(const void* a, const void* b) {
+	return ((const ArchiveEntry*)a)->key - ((const ArchiveEntry*)b)->key;
 }
 
-// compute feature map for all convolutional filters and the 3 image pixel color arrays, used for RGB, CMY, HSV, and HSL
-void convolve3() {
-	for (f = 0; f < numFiltersPerColor; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c1);
-	}
-	for (f = numFiltersPerColor; f < numFiltersPerColor * 2; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c2);
+// create the address of the archive of a visual condition and challenge level
+char* getArchiveAddress(char condition, char challenge) {
+	if (condition == 0) {
+		snprintf(currentAddress, sizeof(currentAddress), "%s%s.zip", archiveRoot, conditionNames[0]);
 	}
-	for (f = numFiltersPerColor * 2; f < numFilters; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c3);
+	else {
+		snprintf(currentAddress, sizeof(currentAddress), "%s%s-%i.zip", archiveRoot, conditionNames[(int)condition], challenge);
 	}
+	return currentAddress;
 }
 
-// compute feature map for all convolutional filters and the 4 image pixel color arrays, used for RGBK and CMYK
-void convolve4() {
-	for (f = 0; f < numFiltersPerColor; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c1);
+// open the archive of a visual condition and challenge level and index its images from its central directory, which lists every entry's name,
+// compression, sizes, and position; entries named like 01_SS_CC_LL_NNNN.bmp, in any folder of the archive, are indexed by sign type and number
+void indexArchive(char condition, char challenge) {
+	Archive* archive = &archives[condition == 0 ? 0 : (condition - 1) * 5 + challenge];
+	char* address = getArchiveAddress(condition, challenge);
+	unsigned char* directory = NULL;
+	unsigned char* p = NULL;
+	unsigned char* end = NULL;
+	char name[64];
+	long archiveSize = 0;
+	int tailSize = 0;
+	int found = -1;
+	unsigned int directorySize = 0;
+	unsigned int directoryOffset = 0;
+	int nameLength = 0;
+	int sign = 0;
+	int number = 0;
+	int n = 0;
+
+	archive->indexed = 1;
+	fopen_s(&archive->fp, address, "rb");
+	if (archive->fp == NULL) {
+		printf("Couldn't open archive %s\n", address);
+		return;
 	}
-	for (f = numFiltersPerColor; f < numFiltersPerColor * 2; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c2);
+
+	// the end of central directory record is in the last 22 bytes, or further back if the archive has a comment
+	fseek(archive->fp, 0, SEEK_END);
+	archiveSize = ftell(archive->fp);
+	tailSize = archiveSize < 22 + 65535 ? (int)archiveSize : 22 + 65535;
+	fseek(archive->fp, archiveSize - tailSize, SEEK_SET);
+	if (fread(archiveData, 1, tailSize, archive->fp) != (size_t)tailSize) {
+		tailSize = 0;
+	}
+	for (int k = tailSize - 22; k >= 0; k--) {
+		if (read32(archiveData + k) == 0x06054b50) {
+			found = k;
+			break;
+		}
 	}
-	for (f = numFiltersPerColor * 2; f < numFiltersPerColor * 3; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c3);
+	if (found < 0) {
+		printf("%s is not a ZIP archive\n", address);
+		return;
 	}
-	for (f = numFiltersPerColor * 3; f < numFilters; f++) {
-		nnInputs[f] = -999999999.0f;
-		F = filter[f];
-		convolveColor(c4);
+	n = read16(archiveData + found + 10);
+	directorySize = read32(archiveData + found + 12);
+	directoryOffset = read32(archiveData + found + 16);
+	if (n == 0xffff || directoryOffset == 0xffffffff || (long)directoryOffset + (long)directorySize > archiveSize) {
+		printf("%s is a ZIP64 archive, which is not supported\n", address);
+		return;
 	}
-}
 
-// executes either convolve1, convolve3, or convolve4 depending on the number of colors in the current color model
-void convolve() {
-	char nc = getNumColors();
-	switch (nc) {
-	case 1:
-		convolve1();
-		break;
-	case 3:
-		convolve3();
-		break;
-	case 4:
-		convolve4();
-		break;
+	// the whole central directory is read at once
+	directory = (unsigned char*)malloc(directorySize + 1);
+	archive->entries = (ArchiveEntry*)malloc(sizeof(ArchiveEntry) * (n > 0 ? n : 1));
+	if (directory == NULL || archive->entries == NULL) {
+		printf("Not enough memory to index %s\n", address);
+		free(directory);
+		return;
 	}
-	// subtract average of previous feature presence values from each neural network input, update the average as part of training
-	int totalLength = imageNumber + 1;
-	if (imageNumber < numTraining) {
-		for (int i = 0; i < numFilters; i++) {
-			nnInputTotals[i] += nnInputs[i];
-			nnInputs[i] -= nnInputTotals[i] / totalLength;
-		}
+	fseek(archive->fp, directoryOffset, SEEK_SET);
+	if (fread(directory, 1, directorySize, archive->fp) != directorySize) {
+		printf("Couldn't read the central directory of %s\n", address);
+		free(directory);
+		return;
 	}
-	else {
-		totalLength = numTraining;
-		for (int i = 0; i < numFilters; i++) {
-			nnInputs[i] -= nnInputTotals[i] / totalLength;
+	p = directory;
+	end = directory + directorySize;
+	while (archive->numEntries < n && p + 46 <= end && read32(p) == 0x02014b50) {
+		nameLength = read16(p + 28);
+		if (p + 46 + nameLength > end) {
+			break;
+		}
+
+		// the name's folders are skipped
+		int start = nameLength;
+		while (start > 0 && p[46 + start - 1] != '/' && p[46 + start - 1] != '\\') {
+			start--;
+		}
+		int length = nameLength - start < (int)sizeof(name) - 1 ? nameLength - start : (int)sizeof(name) - 1;
+		memcpy(name, p + 46 + start, length);
+		name[length] = '\0';
+
+		if (length > 4 && strcmp(name + length - 4, ".bmp") == 0 && sscanf(name, "%*d_%d_%*d_%*d_%d", &sign, &number) == 2 && sign >= 1 &&
+			sign <= 14 && number >= 1 && number <= maxImagesPerSign) {
+			ArchiveEntry* entry = &archive->entries[archive->numEntries];
+			entry->key = sign * 10000 + number;
+			entry->method = read16(p + 10);
+			entry->compressedSize = read32(p + 20);
+			entry->size = read32(p + 24);
+			entry->offset = read32(p + 42);
+			archive->numEntries++;
 		}
+		p += 46 + nameLength + read16(p + 30) + read16(p + 32);
 	}
+	free(directory);
+	qsort(archive->entries, archive->numEntries, sizeof(ArchiveEntry), compareEntries);
 }
 
-// compute neural network hidden layer and outputs from inputs, weights, and biases; return greatest output value as the classification prediction as to the traffic sign type
-char computeNN() {
-	float max = -999999999.0f;
-	char maxIndex = -1;
-	for (int i = 0; i < numFilters; i++) {
-		nnHidden[i] = nnBiases1[i];
-		for (int j = 0; j < numFilters; j++) {
-			nnHidden[i] += nnInputs[j] * nnWeights1[i][j];
-		}
-		if (nnHidden[i] < 0.0f) {
-			nnHidden[i] = 0.0f;
+// index the archives of every visual condition and challenge level in the sample, before the trials
+void indexArchives() {
+	double begin = getMilliseconds();
+	int numArchives = 0;
+	int numEntries = 0;
+	for (int n = 0; n < numTotal; n++) {
+		Archive* archive = &archives[imageConditions[n] == 0 ? 0 : (imageConditions[n] - 1) * 5 + imageChallenges[n]];
+		if (!archive->indexed) {
+			indexArchive(imageConditions[n], imageChallenges[n]);
+			numArchives++;
+			numEntries += archive->numEntries;
 		}
 	}
-	for (int i = 0; i < 14; i++) {
-		nnOutputs[i] = nnBiases2[i];
-		for (int j = 0; j < numFilters; j++) {
-			nnOutputs[i] += nnHidden[j] * nnWeights2[i][j];
+	printf("Indexed %i images in %i archives in %fms\n\n", numEntries, numArchives, getMilliseconds() - begin);
+}
+
+// read an image from its folder's archive into the file array, decompressing it if needed, and fill the RGB arrays from it; images that are missing,
+// compressed with an unsupported method, or fail to decompress are skipped (see imageSkipped)
+void readArchive(char condition, char challenge, char sign, int number) {
+	Archive* archive = &archives[condition == 0 ? 0 : (condition - 1) * 5 + challenge];
+	ArchiveEntry key;
+	ArchiveEntry* entry = NULL;
+	unsigned char header[30];
+	int size = -1;
+
+	if (!archive->indexed) {
+		indexArchive(condition, challenge);
+	}
+	key.key = sign * 10000 + number;
+	if (archive->numEntries > 0) {
+		entry = (ArchiveEntry*)bsearch(&key, archive->entries, archive->numEntries, sizeof(ArchiveEntry), compareEntries);
+	}
+	if (entry == NULL) {
+		printf("Couldn't find image %i of sign %i in %s\n", number, sign, getArchiveAddress(condition, challenge));
+	}
+	else if (entry->compressedSize > maxFileSize || (entry->method != 0 && entry->method != 8)) {
+		printf("Image %i of sign %i in %s is too large or compressed with unsupported method %i\n", number, sign, getArchiveAddress(condition, challenge),
+		entry->method);
+	}
+	else {
+		// the local header gives the lengths of the name and extra field before the data, which may differ from the central directory's
+		fseek(archive->fp, entry->offset, SEEK_SET);
+		if (fread(header, 1, 30, archive->fp) == 30 && read32(header) == 0x04034b50) {
+			fseek(archive->fp, read16(header + 26) + read16(header + 28), SEEK_CUR);
+			if (entry->method == 0) {
+				size = (int)fread(file, 1, entry->compressedSize, archive->fp);
+			}
+			else if (fread(archiveData, 1, entry->compressedSize, archive->fp) == entry->compressedSize) {
+				size = inflateEntry(entry->compressedSize);
+			}
 		}
-		if (nnOutputs[i] > max) {
-			max = nnOutputs[i];
-			maxIndex = i;
+		if (size < 0 || (unsigned int)size != entry->size) {
+			printf("Couldn't read image %i of sign %i in %s\n", number, sign, getArchiveAddress(condition, challenge));
 		}
 	}
-	return maxIndex + 1;
-}
 
-// trains the CNN after a classification is done
-void train(char prediction, char correct) {
-	char pr = prediction - 1;
-	char co = correct - 1;
+	// an image that could not be read is skipped, since the file array still holds the previous image
+	if (entry == NULL || size < 0 || (unsigned int)size != entry->size) {
+		width = 0;
+		height = 0;
+		lineLength = 0;
+		numPixels = 0;
+		imageSkipped = 1;
+		return;
+	}
+	decodeFile(getAddress(condition, challenge, sign, number));
+}
 
-	int colorsGreater = 0;
+// resample the image read by readFile to targetWidth by targetHeight pixels, so the cost of each image is the same
+void resizeImage() {
+	if (width == 0 || height == 0) {
+		return;
+	}
 
-	for (int i = 0; i < numFilters; i++) {
-		
-		// selecting the pixel color array that applies to the convolutional filter being trained
-		unsigned char* current = NULL;
-		if (i < numFiltersPerColor) {
-			current = c1;
-		}
-		else {
-			if (i < numFiltersPerColor * 2) {
-				current = c2;
+	int y0, y1, x0, x1, count;
+	int totalR, totalG, totalB;
+	float sy, sx, wy, wx;
+	int index = 0;
+
+	for (int i = 0; i < targetHeight; i++) {
+		for (int j = 0; j < targetWidth; j++) {
+			index = i * targetWidth + j;
+			if (resizeFilter == 0) {
+				// average every source pixel covered by the target pixel; when enlarging, the nearest source pixel is used
+				y0 = i * height / targetHeight;
+				y1 = (i + 1) * height / targetHeight;
+				x0 = j * width / targetWidth;
+				x1 = (j + 1) * width / targetWidth;
+				if (y1 <= y0) { y1 = y0 + 1; }
+				if (x1 <= x0) { x1 = x0 + 1; }
+				totalR = 0;
+				totalG = 0;
+				totalB = 0;
+				for (int y = y0; y < y1; y++) {
+					for (int x = x0; x < x1; x++) {
+						totalR += r[y * width + x];
+						totalG += g[y * width + x];
+						totalB += b[y * width + x];
+					}
+				}
+				count = (y1 - y0) * (x1 - x0);
+				resizedR[index] = (unsigned char)((totalR + count / 2) / count);
+				resizedG[index] = (unsigned char)((totalG + count / 2) / count);
+				resizedB[index] = (unsigned char)((totalB + count / 2) / count);
 			}
 			else {
-				if (i < numFiltersPerColor * 3) {
-					current = c3;
-				}
-				else {
-					current = c4;
-				}
+				// interpolate between the four source pixels surrounding the center of the target pixel
+				sy = ((float)i + 0.5f) * (float)height / (float)targetHeight - 0.5f;
+				sx = ((float)j + 0.5f) * (float)width / (float)targetWidth - 0.5f;
+				if (sy < 0.0f) { sy = 0.0f; }
+				if (sx < 0.0f) { sx = 0.0f; }
+				y0 = (int)sy;
+				x0 = (int)sx;
+				y1 = y0 + 1 < height ? y0 + 1 : y0;
+				x1 = x0 + 1 < width ? x0 + 1 : x0;
+				wy = sy - (float)y0;
+				wx = sx - (float)x0;
+				resizedR[index] = (unsigned char)((1.0f - wy) * ((1.0f - wx) * r[y0 * width + x0] + wx * r[y0 * width + x1]) + wy * ((1.0f - wx) * r[y1 * width + x0] + wx * r[y1 * width + x1]) + 0.5f);
+				resizedG[index] = (unsigned char)((1.0f - wy) * ((1.0f - wx) * g[y0 * width + x0] + wx * g[y0 * width + x1]) + wy * ((1.0f - wx) * g[y1 * width + x0] + wx * g[y1 * width + x1]) + 0.5f);
+				resizedB[index] = (unsigned char)((1.0f - wy) * ((1.0f - wx) * b[y0 * width + x0] + wx * b[y0 * width + x1]) + wy * ((1.0f - wx) * b[y1 * width + x0] + wx * b[y1 * width + x1]) + 0.5f);
 			}
 		}
-		
-		// changing filter values
-		float av = 0.0f;
+	}
+
+	// replace the RGB arrays with the image at the new resolution
+	width = targetWidth;
+	height = targetHeight;
+	numPixels = width * height;
+
+	for (int i = 0; i < numPixels; i++) {
+		r[i] = resizedR[i];
+		g[i] = resizedG[i];
+		b[i] = resizedB[i];
+	}
+
+	r[numPixels] = 0;
+	g[numPixels] = 0;
+	b[numPixels] = 0;
+}
+
+// fill all convolutional filters, neural network weights, and neural network biases with values prior to training in each trial
+// only the filterArea values used by the trial's filter size are drawn, so the random values do not depend on maxFilterSize
+void randomizeParameters() {
+	for (int i = 0; i < maxNumFilters; i++) {
 		for (int j = 0; j < filterArea; j++) {
-			av += 0.0001f * (float)current[(filterMapMaxI[i] + (j / filterSize) - padding) * width + filterMapMaxJ[i] + (j % filterSize) - padding] / (float)(imageNumber + 1);
+			filter[i][j] = randFloat(trialRandom, -5.0f, 10.0f);
 		}
-		for (int j = 0; j < filterArea; j++) {
-			filter[i][j] += 0.0001f * (float)current[(filterMapMaxI[i] + (j / filterSize) - padding) * width + filterMapMaxJ[i] + (j % filterSize) - padding] / (float)(imageNumber + 1);
-			filter[i][j] -= av / (float)filterArea;
+		for (int j = filterArea; j < maxFilterArea; j++) {
+			filter[i][j] = 0.0f;
+		}
+		for (int j = 0; j < maxNumFilters; j++) {
+			nnWeights1[j][i] = randFloat(trialRandom, -0.5f, 1.0f);
+		}
+		for (int j = 0; j < 14; j++) {
+			nnWeights2[j][i] = randFloat(trialRandom, -0.5f, 1.0f);
+		}
+		nnBiases1[i] = 0.0f;
+	}
+	for (int i = 0; i < 14; i++) {
+		nnBiases2[i] = 0.0f;
+	}
+	for (int i = 0; i < maxNumFilters; i++) {
+		nnInputTotals[i] = 0.0f;
+	}
+}
+
+// terms of the unrolled convolution sum for a filter of size n centered on pixel (i, j); each is one filter value times the pixel it covers
+#define KERNEL_TAP(n, row, col) F[(row) * (n) + (col)] * (float)a[(i + (row) - (n) / 2) * width + j + (col) - (n) / 2]
+
+// sum of the first k taps of one filter row
+#define KERNEL_COLS_1(n, row) KERNEL_TAP(n, row, 0)
+#define KERNEL_COLS_2(n, row) KERNEL_COLS_1(n, row) + KERNEL_TAP(n, row, 1)
+#define KERNEL_COLS_3(n, row) KERNEL_COLS_2(n, row) + KERNEL_TAP(n, row, 2)
+#define KERNEL_COLS_4(n, row) KERNEL_COLS_3(n, row) + KERNEL_TAP(n, row, 3)
+#define KERNEL_COLS_5(n, row) KERNEL_COLS_4(n, row) + KERNEL_TAP(n, row, 4)
+#define KERNEL_COLS_6(n, row) KERNEL_COLS_5(n, row) + KERNEL_TAP(n, row, 5)
+#define KERNEL_COLS_7(n, row) KERNEL_COLS_6(n, row) + KERNEL_TAP(n, row, 6)
+#define KERNEL_COLS_8(n, row) KERNEL_COLS_7(n, row) + KERNEL_TAP(n, row, 7)
+#define KERNEL_COLS_9(n, row) KERNEL_COLS_8(n, row) + KERNEL_TAP(n, row, 8)
+#define KERNEL_COLS_10(n, row) KERNEL_COLS_9(n, row) + KERNEL_TAP(n, row, 9)
+#define KERNEL_COLS_11(n, row) KERNEL_COLS_10(n, row) + KERNEL_TAP(n, row, 10)
+#define KERNEL_COLS_12(n, row) KERNEL_COLS_11(n, row) + KERNEL_TAP(n, row, 11)
+#define KERNEL_COLS_13(n, row) KERNEL_COLS_12(n, row) + KERNEL_TAP(n, row, 12)
+#define KERNEL_COLS_14(n, row) KERNEL_COLS_13(n, row) + KERNEL_TAP(n, row, 13)
+#define KERNEL_COLS_15(n, row) KERNEL_COLS_14(n, row) + KERNEL_TAP(n, row, 14)
+
+// sum of the first k filter rows; the terms are added one at a time from the first filter value to the last, the same order as a flat sum of all
+// of them, so leaving out the rows that lie outside a black surrounding (whose terms are 0) does not change the result
+#define KERNEL_ROWS_1(n, cols) cols(n, 0)
+#define KERNEL_ROWS_2(n, cols) KERNEL_ROWS_1(n, cols) + cols(n, 1)
+#define KERNEL_ROWS_3(n, cols) KERNEL_ROWS_2(n, cols) + cols(n, 2)
+#define KERNEL_ROWS_4(n, cols) KERNEL_ROWS_3(n, cols) + cols(n, 3)
+#define KERNEL_ROWS_5(n, cols) KERNEL_ROWS_4(n, cols) + cols(n, 4)
+#define KERNEL_ROWS_6(n, cols) KERNEL_ROWS_5(n, cols) + cols(n, 5)
+#define KERNEL_ROWS_7(n, cols) KERNEL_ROWS_6(n, cols) + cols(n, 6)
+#define KERNEL_ROWS_8(n, cols) KERNEL_ROWS_7(n, cols) + cols(n, 7)
+#define KERNEL_ROWS_9(n, cols) KERNEL_ROWS_8(n, cols) + cols(n, 8)
+#define KERNEL_ROWS_10(n, cols) KERNEL_ROWS_9(n, cols) + cols(n, 9)
+#define KERNEL_ROWS_11(n, cols) KERNEL_ROWS_10(n, cols) + cols(n, 10)
+#define KERNEL_ROWS_12(n, cols) KERNEL_ROWS_11(n, cols) + cols(n, 11)
+#define KERNEL_ROWS_13(n, cols) KERNEL_ROWS_12(n, cols) + cols(n, 12)
+#define KERNEL_ROWS_14(n, cols) KERNEL_ROWS_13(n, cols) + cols(n, 13)
+#define KERNEL_ROWS_15(n, cols) KERNEL_ROWS_14(n, cols) + cols(n, 14)
+
+
+// full convolution sum for a filter of size n, written out term by term by the preprocessor
+#define KERNEL_SUM(n) KERNEL_ROWS_##n(n, KERNEL_COLS_##n)
+
+// get the color of pixel (i, j) of an image pixel color array; pixels outside the image have the color of the area around it
+unsigned char getPixel(unsigned char* a, int i, int j) {
+	if (i < 0 || i >= height || j < 0 || j >= width) {
+		return a[numPixels];
+	}
+	return a[i * width + j];
+}
+
+// compute the feature map from pixel j0 up to pixel j1 of row i for the selected filter, leaving out or substituting the pixels under the filter that
+// are outside the image; used within half a filter of the image's edges
+void convolveBorder(unsigned char* a, int i, int j0, int j1) {
+	float total = 0;
+	float outside = (float)a[numPixels];
+	int r0 = padding - i > 0 ? padding - i : 0;
+	int r1 = height - i + padding < filterSize ? height - i + padding : filterSize;
+	int c0, c1, x;
+	for (int j = j0; j < j1; j++) {
+		total = 0.0f;
+		if (outside == 0.0f) {
+			// pixels outside the image add nothing, so only the filter values over the image are used
+			c0 = padding - j > 0 ? padding - j : 0;
+			c1 = width - j + padding < filterSize ? width - j + padding : filterSize;
+			for (int y = r0; y < r1; y++) {
+				for (int c = c0; c < c1; c++) {
+					total += F[y * filterSize + c] * (float)a[(i + y - padding) * width + j + c - padding];
+				}
+			}
+		}
+		else {
+			for (int y = 0; y < filterSize; y++) {
+				for (int c = 0; c < filterSize; c++) {
+					x = j + c - padding;
+					total += F[y * filterSize + c] * (y < r0 || y >= r1 || x < 0 || x >= width ? outside : (float)a[(i + y - padding) * width + x]);
+				}
+			}
+		}
+		if (total > *mapMax) {
+			*mapMax = total;
+			*mapMaxI = i;
+			*mapMaxJ = j;
+		}
+	}
+}
+
+// allocate a buffer of the calling thread and write to all of it, so the system places its memory on that thread's NUMA node (first touch)
+void* allocateLocal(size_t bytes) {
+	void* buffer = malloc(bytes);
+	if (buffer == NULL) {
+		printf("Not enough memory for %i bytes of thread buffers\n", (int)bytes);
+		exit(1);
+	}
+	memset(buffer, 0, bytes);
+	return buffer;
+}
+
+// copies of the selected filter with the columns that would fall outside the image set to 0, for each of the pixels within half a filter of the left
+// edge (the first padding copies) and of the right edge (the rest); allocated by each thread when it first uses them
+threadLocal float (*borderFilters)[maxFilterArea] = NULL;
+
+// fill borderFilters for the selected filter
+void prepareBorderFilters() {
+	if (borderFilters == NULL) {
+		borderFilters = (float (*)[maxFilterArea])allocateLocal(sizeof(float) * (maxFilterSize - 1) * maxFilterArea);
+	}
+	for (int d = 0; d < padding; d++) {
+		for (int k = 0; k < filterArea; k++) {
+			borderFilters[d][k] = k % filterSize < padding - d ? 0.0f : F[k];
+			borderFilters[padding + d][k] = k % filterSize > padding + d ? 0.0f : F[k];
+		}
+	}
+}
+
+// compare a value of the feature map to the maximum found so far
+#define KERNEL_MAX(total) \
+	if (total > *mapMax) { \
+		*mapMax = total; \
+		*mapMaxI = i; \
+		*mapMaxJ = j; \
+	}
+
+// one case of convolveColor: the feature map of an n by n filter, with every term of the sum unrolled. Where the area around the image is black,
+// the pixels near the left and right edges use a copy of the filter with the columns outside the image set to 0, and the rows near the top and bottom
+// edges sum only the filter rows over the image; the corners, and every border pixel of images with other surroundings, use convolveBorder
+#define KERNEL_CASE(n) \
+	case n: \
+		black = a[numPixels] == 0 && width > 2 * ((n) / 2); \
+		if (black) { \
+			prepareBorderFilters(); \
+		} \
+		for (int i = rowStart; i < rowEnd; i++) { \
+			if (i >= (n) / 2 && i < height - (n) / 2) { \
+				if (black && i > (n) / 2) { \
+					for (int j = 0; j < (n) / 2; j++) { \
+						float* F = borderFilters[j]; \
+						total = KERNEL_SUM(n); \
+						KERNEL_MAX(total) \
+					} \
+				} \
+				else { \
+					convolveBorder(a, i, 0, (n) / 2 < width ? (n) / 2 : width); \
+				} \
+				for (int j = (n) / 2; j < width - (n) / 2; j++) { \
+					total = KERNEL_SUM(n); \
+					KERNEL_MAX(total) \
+				} \
+				if (black) { \
+					for (int j = width - (n) / 2; j < width; j++) { \
+						float* F = borderFilters[(n) / 2 + width - 1 - j]; \
+						total = KERNEL_SUM(n); \
+						KERNEL_MAX(total) \
+					} \
+				} \
+				else { \
+					convolveBorder(a, i, width - (n) / 2 > (n) / 2 ? width - (n) / 2 : (n) / 2, width); \
+				} \
+				continue; \
+			} \
+			convolveBorder(a, i, 0, (n) / 2 < width ? (n) / 2 : width); \
+			if (black) { \
+				r0 = (n) / 2 - i > 0 ? (n) / 2 - i : 0; \
+				r1 = height - i + (n) / 2 < (n) ? height - i + (n) / 2 : (n); \
+				for (int j = (n) / 2; j < width - (n) / 2; j++) { \
+					total = 0.0f; \
+					for (int y = r0; y < r1; y++) { \
+						total = total + KERNEL_COLS_##n(n, y); \
+					} \
+					KERNEL_MAX(total) \
+				} \
+			} \
+			else { \
+				convolveBorder(a, i, (n) / 2, width - (n) / 2); \
+			} \
+			convolveBorder(a, i, width - (n) / 2 > (n) / 2 ? width - (n) / 2 : (n) / 2, width); \
+		} \
+		break;
+
+// compute feature map for one convolutional filter and one image pixel color array with loops over the filter, used for any filter size
+void convolveColorGeneric(unsigned char* a) {
+	float total = 0;
+	for (int i = rowStart; i < rowEnd; i++) {
+		convolveBorder(a, i, 0, padding < width ? padding : width);
+		if (i >= padding && i < height - padding) {
+			for (int j = padding; j < width - padding; j++) {
+				total = 0.0f;
+				for (int y = 0; y < filterSize; y++) {
+					for (int c = 0; c < filterSize; c++) {
+						total += F[y * filterSize + c] * (float)a[(i + y - padding) * width + j + c - padding];
+					}
+				}
+				if (total > *mapMax) {
+					*mapMax = total;
+					*mapMaxI = i;
+					*mapMaxJ = j;
+				}
+			}
+		}
+		else {
+			convolveBorder(a, i, padding, width - padding);
+		}
+		convolveBorder(a, i, width - padding > padding ? width - padding : padding, width);
+	}
+}
+
+// image pixel color array converted to floats for the rows kernel, the array it was converted from, and the conversion count when it was converted
+threadLocal float* floatPlane = NULL;
+threadLocal unsigned char* floatPlaneSource = NULL;
+threadLocal int floatPlaneVersion = -1;
+
+// one row of the feature map computed by the rows kernel; this and floatPlane are allocated by each thread when it first uses the rows kernel
+threadLocal float* mapRow = NULL;
+
+// free the calling thread's kernel buffers, so they are allocated again where the thread runs next
+void releaseThreadBuffers() {
+	free(borderFilters);
+	free(floatPlane);
+	free(mapRow);
+	borderFilters = NULL;
+	floatPlane = NULL;
+	mapRow = NULL;
+	floatPlaneSource = NULL;
+}
+
+// compute feature map for one convolutional filter and one image pixel color array a row at a time: each filter value is multiplied by a whole row
+// of the image as floats, so the loops over the row can be vectorized by the compiler; the terms are added in the same order as the other kernels
+void convolveColorRows(unsigned char* a) {
+	if (floatPlane == NULL) {
+		floatPlane = (float*)allocateLocal(sizeof(float) * maxImageSize);
+		mapRow = (float*)allocateLocal(sizeof(float) * maxImageSize);
+	}
+	if (a != floatPlaneSource || floatPlaneVersion != planeVersion) {
+		for (int i = 0; i < numPixels; i++) {
+			floatPlane[i] = (float)a[i];
+		}
+		floatPlaneSource = a;
+		floatPlaneVersion = planeVersion;
+	}
+
+	int length = width - 2 * padding;
+	float value = 0.0f;
+	float* line = NULL;
+	for (int i = rowStart; i < rowEnd; i++) {
+		convolveBorder(a, i, 0, padding < width ? padding : width);
+		if (i >= padding && i < height - padding && length > 0) {
+			for (int j = 0; j < length; j++) {
+				mapRow[j] = 0.0f;
+			}
+			for (int y = 0; y < filterSize; y++) {
+				for (int c = 0; c < filterSize; c++) {
+					value = F[y * filterSize + c];
+					line = floatPlane + (i + y - padding) * width + c;
+					for (int j = 0; j < length; j++) {
+						mapRow[j] += value * line[j];
+					}
+				}
+			}
+			for (int j = 0; j < length; j++) {
+				if (mapRow[j] > *mapMax) {
+					*mapMax = mapRow[j];
+					*mapMaxI = i;
+					*mapMaxJ = j + padding;
+				}
+			}
+		}
+		else {
+			convolveBorder(a, i, padding, width - padding);
+		}
+		convolveBorder(a, i, width - padding > padding ? width - padding : padding, width);
+	}
+}
+
+// compute feature map for one convolutional filter and one image pixel color array with the unrolled kernels
+void convolveColorUnrolled(unsigned char* a) {
+	float total = 0;
+	int r0, r1;
+	char black;
+	switch (filterSize) {
+	KERNEL_CASE(3)
+	KERNEL_CASE(5)
+	KERNEL_CASE(7)
+	KERNEL_CASE(9)
+	KERNEL_CASE(11)
+#if maxFilterSize >= 13
+	KERNEL_CASE(13)
+#endif
+#if maxFilterSize >= 15
+	KERNEL_CASE(15)
+#endif
+	default:
+		convolveColorGeneric(a);
+		break;
+	}
+}
+
+// compute feature map for one convolutional filter and one image pixel color array with the kernel chosen for the current trial
+void convolveColor(unsigned char* a) {
+	switch (kernel) {
+	case 1:
+		convolveColorGeneric(a);
+		break;
+	case 2:
+		convolveColorRows(a);
+		break;
+	default:
+		convolveColorUnrolled(a);
+		break;
+	}
+}
+
+// get filter number n of the current trial as 32-bit floats, converting it from its 16-bit storage if the trial is tested with it
+float* loadFilter(int n) {
+	if (!useStoredParameters) {
+		return filter[n];
+	}
+	unsigned short* stored = currentTrial->storedFilter[n];
+	for (int i = 0; i < filterArea; i++) {
+		loadedFilter[i] = loadParameter(stored[i]);
+	}
+	return loadedFilter;
+}
+
+// get the image pixel color array that filter number n is applied to; the filters are divided equally between the colors of the color model
+unsigned char* getFilterColors(int n) {
+	switch (n / numFiltersPerColor) {
+	case 0: return c1;
+	case 1: return c2;
+	case 2: return c3;
+	}
+	return c4;
+}
+
+// compute the feature map of filter number n over rows i0 up to i1 of its image pixel color array, keeping the maximum and its position in max, maxI,
+// and maxJ
+void convolveFilter(int n, int i0, int i1, float* max, int* maxI, int* maxJ) {
+	mapMax = max;
+	mapMaxI = maxI;
+	mapMaxJ = maxJ;
+	rowStart = i0;
+	rowEnd = i1;
+	*max = -999999999.0f;
+	F = loadFilter(n);
+	convolveColor(getFilterColors(n));
+}
+
+// threads used to convolve each image, including the main thread; with more than 1, the filters of each image are shared between the threads, and a
+// thread that finishes its share takes filters from the others' shares (work stealing)
+int numThreads = 1;
+#define maxThreads 64
+
+// set to 1 to also split each feature map into bands of rows when there are fewer than 2 filters per thread, so small filter counts keep every
+// thread busy; bands have at least minBandRows rows
+char splitRows = 1;
+#define maxBands 16
+#define minBandRows 8
+
+// set to 1 to time the classification of single images with 1, 2, 4, and so on up to numThreads threads before the trials
+char reportLatency = 0;
+#define latencyImages 25
+
+// images tested together when above 1 (up to maxBatchSize): each block of up to batchFilterBlock filters of one color is applied to every image of
+// the batch before the next block, so each filter is loaded once per batch instead of once per image; used while images are convolved on one thread
+int batchSize = 1;
+#define maxBatchSize 16
+#define batchFilterBlock 8
+
+// set to 1 to time the classification of test images in batches of 1, 2, 4, and so on up to maxBatchSize before the trials
+char reportBatchThroughput = 0;
+#define throughputImages 64
+
+// threads taking part in convolving the current image: numThreads, or fewer while the latency is timed
+int threadsUsed = 1;
+
+// feature map maximums and their positions for each band of rows of each filter, combined into nnInputs and filterMapMaxI/J once all are computed
+float bandMax[maxNumFilters][maxBands];
+int bandMaxI[maxNumFilters][maxBands];
+int bandMaxJ[maxNumFilters][maxBands];
+int numBands = 1;
+
+// tasks (filters, or bands of rows of filters) of the image being convolved, numbered filter by filter; each thread has a share of them, from next
+// up to end, and any thread can take the next task of a share by incrementing next. Each share is on its own cache line
+typedef struct TaskShare {
+	int next;
+	int end;
+	char unused[56];
+} TaskShare;
+TaskShare taskShares[maxThreads];
+
+// tasks finished and threads done with the current image
+int tasksDone = 0;
+int threadsDone = 0;
+
+// incremented to start the threads on the tasks of an image; while the main thread is convolving an image, a waiting thread checks it up to spinCount
+// times, letting other threads run in between, before sleeping until it is signaled, and once the main thread is done with the image it sleeps
+// right away, so no CPU time is spent spinning while the main thread computes the neural network, trains, or reads the next image
+int taskRound = 0;
+int convolving = 0;
+#define spinCount 2000
+int threadsStarted = 0;
+
+#ifdef _WIN32
+SRWLOCK taskLock = SRWLOCK_INIT;
+CONDITION_VARIABLE taskSignal = CONDITION_VARIABLE_INIT;
+#define lockTasks() AcquireSRWLockExclusive(&taskLock)
+#define unlockTasks() ReleaseSRWLockExclusive(&taskLock)
+#define waitForTasks() SleepConditionVariableSRW(&taskSignal, &taskLock, INFINITE, 0)
+#define signalTasks() WakeAllConditionVariable(&taskSignal)
+#define yieldThread() SwitchToThread()
+#else
+pthread_mutex_t taskLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t taskSignal = PTHREAD_COND_INITIALIZER;
+#define lockTasks() pthread_mutex_lock(&taskLock)
+#define unlockTasks() pthread_mutex_unlock(&taskLock)
+#define waitForTasks() pthread_cond_wait(&taskSignal, &taskLock)
+#define signalTasks() pthread_cond_broadcast(&taskSignal)
+#define yieldThread() sched_yield()
+#endif
+
+// run task number t: band t % numBands of filter t / numBands
+void runTask(int t) {
+	int n = t / numBands;
+	int band = t % numBands;
+	if (numBands == 1) {
+		convolveFilter(n, 0, height, &nnInputs[n], &filterMapMaxI[n], &filterMapMaxJ[n]);
+	}
+	else {
+		convolveFilter(n, band * height / numBands, (band + 1) * height / numBands, &bandMax[n][band], &bandMaxI[n][band], &bandMaxJ[n][band]);
+	}
+}
+
+// run the tasks of thread number id's share, then take tasks from the other shares until every task has been taken
+void runTasks(int id) {
+	int done = 0;
+	int t = 0;
+	for (int k = 0; k < threadsUsed; k++) {
+		TaskShare* share = &taskShares[(id + k) % threadsUsed];
+		while ((t = atomicAdd(&share->next, 1)) < share->end) {
+			runTask(t);
+			done++;
+		}
+	}
+	atomicAdd(&tasksDone, done);
+}
+
+// placement of the threads on machines with more than one NUMA node: 0 to leave it to the system, 1 to pin each thread to its own CPU, filling the
+// main thread's node before the next (so a few threads share one node's memory and cache), 2 to pin them spread across the nodes in turn (so many
+// threads share the memory bandwidth of every node); set pinOneNode to 1 to also pin them on machines with a single node
+char placeThreads = 1;
+char pinOneNode = 0;
+
+// CPUs this process may use and the NUMA node of each, read when the threads are started, and the CPU each thread is pinned to (-1 if it is not)
+#define maxCPUs 1024
+#define maxNodes 64
+int numCPUs = 0;
+int numNodes = 0;
+short cpuNumbers[maxCPUs];
+short cpuNodes[maxCPUs];
+short nodeNumbers[maxNodes];
+int threadCPUs[maxThreads];
+
+// add a CPU of NUMA node number node to the topology
+void addCPU(int cpu, int node) {
+	int k = 0;
+	if (numCPUs >= maxCPUs) {
+		return;
+	}
+	while (k < numNodes && nodeNumbers[k] != node) {
+		k++;
+	}
+	if (k == numNodes) {
+		if (numNodes >= maxNodes) {
+			return;
+		}
+		nodeNumbers[numNodes] = node;
+		numNodes++;
+	}
+	cpuNumbers[numCPUs] = cpu;
+	cpuNodes[numCPUs] = k;
+	numCPUs++;
+}
+
+// read the CPUs this process may use and their NUMA nodes from the system; without node information, every CPU is on node 0
+void readTopology() {
+	numCPUs = 0;
+	numNodes = 0;
+#ifdef _WIN32
+	// the first processor group only, up to 64 CPUs
+	DWORD_PTR processMask = 0;
+	DWORD_PTR systemMask = 0;
+	ULONG highest = 0;
+	ULONGLONG nodeMask = 0;
+	GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+	if (!GetNumaHighestNodeNumber(&highest)) {
+		highest = 0;
+	}
+	for (ULONG node = 0; node <= highest && node < maxNodes; node++) {
+		if (!GetNumaNodeProcessorMask((UCHAR)node, &nodeMask)) {
+			nodeMask = node == 0 ? (ULONGLONG)processMask : 0;
+		}
+		for (int cpu = 0; cpu < 64; cpu++) {
+			if ((nodeMask & processMask) >> cpu & 1) {
+				addCPU(cpu, node);
+			}
+		}
+	}
+#elif defined(__linux__)
+	cpu_set_t allowed;
+	char address[64];
+	int first = 0;
+	int last = 0;
+	char separator = 0;
+	FILE* fp;
+	CPU_ZERO(&allowed);
+	sched_getaffinity(0, sizeof(allowed), &allowed);
+
+	// each node lists its CPUs as ranges, for example 0-15,32-47
+	for (int node = 0; node < maxNodes; node++) {
+		snprintf(address, sizeof(address), "/sys/devices/system/node/node%i/cpulist", node);
+		fopen_s(&fp, address, "r");
+		if (fp == NULL) {
+			continue;
+		}
+		while (fscanf(fp, "%i", &first) == 1) {
+			last = first;
+			separator = (char)fgetc(fp);
+			if (separator == '-') {
+				if (fscanf(fp, "%i", &last) != 1) {
+					break;
+				}
+				separator = (char)fgetc(fp);
+			}
+			for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+				if (CPU_ISSET(cpu, &allowed)) {
+					addCPU(cpu, node);
+				}
+			}
+			if (separator != ',') {
+				break;
+			}
+		}
+		fclose(fp);
+	}
+	if (numCPUs == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &allowed)) {
+				addCPU(cpu, 0);
+			}
+		}
+	}
+#endif
+}
+
+// get the CPU the calling thread is running on, or -1 if it is not known
+int getCurrentCPU() {
+#ifdef _WIN32
+	return (int)GetCurrentProcessorNumber();
+#elif defined(__linux__)
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
+
+// choose the CPU of each thread for placeThreads, starting with the node the main thread is running on; with a single node, threads are only pinned
+// with pinOneNode, and then in the order of the CPUs
+void placeThreadsOnCPUs() {
+	int order[maxCPUs];
+	int count = 0;
+	int mainNode = 0;
+	int current = getCurrentCPU();
+	int node = 0;
+	int k = 0;
+
+	for (int id = 0; id < maxThreads; id++) {
+		threadCPUs[id] = -1;
+	}
+	if (placeThreads == 0 || numCPUs == 0 || (numNodes < 2 && !pinOneNode)) {
+		return;
+	}
+	for (int c = 0; c < numCPUs; c++) {
+		if (cpuNumbers[c] == current) {
+			mainNode = cpuNodes[c];
+		}
+	}
+
+	// the CPUs in order of their nodes, the main thread's first
+	for (int n = 0; n < numNodes; n++) {
+		node = (mainNode + n) % numNodes;
+		for (int c = 0; c < numCPUs; c++) {
+			if (cpuNodes[c] == node) {
+				order[count] = c;
+				count++;
+			}
+		}
+	}
+
+	for (int id = 0; id < numThreads; id++) {
+		if (placeThreads == 2 && numNodes > 1) {
+			// the (id / numNodes)th CPU of node number id % numNodes after the main thread's
+			node = (mainNode + id % numNodes) % numNodes;
+			int skip = id / numNodes;
+			int onNode = 0;
+			for (int c = 0; c < numCPUs; c++) {
+				onNode += cpuNodes[c] == node;
+			}
+			skip %= onNode;
+			for (k = 0; k < count; k++) {
+				if (cpuNodes[order[k]] == node) {
+					if (skip == 0) {
+						break;
+					}
+					skip--;
+				}
+			}
+			threadCPUs[id] = cpuNumbers[order[k]];
+		}
+		else {
+			threadCPUs[id] = cpuNumbers[order[id % count]];
+		}
+	}
+}
+
+// pin the calling thread, thread number id, to its CPU if it has one
+void pinThread(int id) {
+	if (threadCPUs[id] < 0) {
+		return;
+	}
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << threadCPUs[id]);
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(threadCPUs[id], &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+// print the NUMA nodes and CPUs found and where the threads are placed
+void printTopology() {
+	int count = 0;
+	printf("Topology: %i CPU%s on %i NUMA node%s (", numCPUs, numCPUs == 1 ? "" : "s", numNodes, numNodes == 1 ? "" : "s");
+	for (int n = 0; n < numNodes; n++) {
+		count = 0;
+		for (int c = 0; c < numCPUs; c++) {
+			count += cpuNodes[c] == n;
+		}
+		printf("%snode %i: %i CPU%s", n > 0 ? ", " : "", nodeNumbers[n], count, count == 1 ? "" : "s");
+	}
+	printf(")\n");
+	if (threadCPUs[0] < 0) {
+		printf("Threads: %i, not pinned%s\n\n", numThreads, placeThreads != 0 && numNodes < 2 ? " (single node)" : "");
+		return;
+	}
+	printf("Threads: %i, pinned %s to CPUs", numThreads, placeThreads == 2 && numNodes > 1 ? "across the nodes" : "node by node");
+	for (int id = 0; id < numThreads; id++) {
+		printf("%s %i", id > 0 ? "," : "", threadCPUs[id]);
+	}
+	printf("\n\n");
+}
+
+// file descriptor leading each thread's group of hardware counters (the main thread's first), -1 if the system does not allow them, and whether each
+// thread has opened its group; each thread can only open counters for itself, and they are read and added up for all threads
+int counterGroups[maxThreads];
+int countersOpened[maxThreads];
+
+// open the hardware counters of the calling thread, thread number id, leaving its group at -1 if the system does not allow it
+void openCounters(int id) {
+	counterGroups[id] = -1;
+#ifdef __linux__
+	unsigned long long configs[numCounters] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+	int files[numCounters];
+	struct perf_event_attr attr;
+	for (int i = 0; i < numCounters; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = configs[i];
+		attr.disabled = i == 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+		files[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : files[0], 0);
+		if (files[i] < 0) {
+			for (int j = 0; j < i; j++) {
+				close(files[j]);
+			}
+			if (id == 0) {
+				printf("Hardware counters are unavailable; stages will only be timed.\n\n");
+			}
+			atomicStore(&countersOpened[id], 1);
+			return;
+		}
+	}
+	ioctl(files[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(files[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	counterGroups[id] = files[0];
+#else
+	if (id == 0) {
+		printf("Hardware counters are only read on Linux; stages will only be timed.\n\n");
+	}
+#endif
+	atomicStore(&countersOpened[id], 1);
+}
+
+// read the current values of the hardware counters added up over all threads that have opened them, or 0s if they are unavailable
+void readCounters(long long* values) {
+	for (int i = 0; i < numCounters; i++) {
+		values[i] = 0;
+	}
+#ifdef __linux__
+	long long group[1 + numCounters];
+	for (int id = 0; id < maxThreads; id++) {
+		if (atomicLoad(&countersOpened[id]) && counterGroups[id] >= 0 && read(counterGroups[id], group, sizeof(group)) == sizeof(group)) {
+			for (int i = 0; i < numCounters; i++) {
+				values[i] += group[1 + i];
+			}
+		}
+	}
+#endif
+}
+
+// each thread other than the main one waits for an image's tasks, helps with them if it takes part, and waits for the next image; every thread
+// reports each image done, so none is still looking at the shares when they are set up for the next
+#ifdef _WIN32
+DWORD WINAPI runThread(LPVOID argument) {
+#else
+void* runThread(void* argument) {
+#endif
+	int id = (int)(size_t)argument;
+	int seen = 0;
+	int spins = 0;
+	pinThread(id);
+	if (measureStages) {
+		openCounters(id);
+	}
+	while (1) {
+		spins = 0;
+		while (atomicLoad(&taskRound) == seen && atomicLoad(&convolving) && spins < spinCount) {
+			yieldThread();
+			spins++;
+		}
+		if (atomicLoad(&taskRound) == seen) {
+			lockTasks();
+			while (atomicLoad(&taskRound) == seen) {
+				waitForTasks();
+			}
+			unlockTasks();
+		}
+		seen = atomicLoad(&taskRound);
+		if (id < threadsUsed) {
+			runTasks(id);
+		}
+		atomicAdd(&threadsDone, 1);
+	}
+	return 0;
+}
+
+// create the threads used to convolve images besides the main thread, placing them and the main thread on CPUs as set by placeThreads; each thread's
+// kernel buffers are allocated once it is pinned
+void startThreads() {
+	if (numThreads > maxThreads) {
+		numThreads = maxThreads;
+	}
+	if (threadsStarted == 0) {
+		readTopology();
+		placeThreadsOnCPUs();
+		if (threadCPUs[0] >= 0) {
+			pinThread(0);
+			releaseThreadBuffers();
+		}
+		printTopology();
+	}
+	for (int id = threadsStarted + 1; id < numThreads; id++) {
+#ifdef _WIN32
+		HANDLE thread = CreateThread(NULL, 0, runThread, (LPVOID)(size_t)id, 0, NULL);
+		if (thread == NULL) {
+			break;
+		}
+		CloseHandle(thread);
+#else
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, runThread, (void*)(size_t)id) != 0) {
+			break;
+		}
+		pthread_detach(thread);
+#endif
+		threadsStarted++;
+	}
+	if (threadsStarted < numThreads - 1) {
+		printf("Only %i threads could be started\n", threadsStarted + 1);
+		numThreads = threadsStarted + 1;
+	}
+
+	// with measureStages, wait until every thread has opened its hardware counters, so each stage counts all of them from the start
+	for (int id = 1; measureStages && id <= threadsStarted; id++) {
+		while (!atomicLoad(&countersOpened[id])) {
+			yieldThread();
+		}
+	}
+	threadsUsed = numThreads;
+}
+
+// compute the feature maps of all filters for the current image with threadsUsed threads, the main thread included, and wait for all of them
+void convolveThreads() {
+	numBands = 1;
+	if (splitRows && numFilters < 2 * threadsUsed) {
+		numBands = (2 * threadsUsed + numFilters - 1) / numFilters;
+		if (numBands > maxBands) {
+			numBands = maxBands;
+		}
+		if (numBands > height / minBandRows) {
+			numBands = height / minBandRows > 0 ? height / minBandRows : 1;
+		}
+	}
+	int count = numFilters * numBands;
+	for (int k = 0; k < threadsUsed; k++) {
+		taskShares[k].next = k * count / threadsUsed;
+		taskShares[k].end = (k + 1) * count / threadsUsed;
+	}
+	atomicStore(&tasksDone, 0);
+	atomicStore(&threadsDone, 0);
+	atomicStore(&convolving, 1);
+
+	lockTasks();
+	atomicAdd(&taskRound, 1);
+	signalTasks();
+	unlockTasks();
+
+	runTasks(0);
+
+	// wait until every task is finished and every thread is done with this image, so the shares can be reused for the next image
+	while (atomicLoad(&tasksDone) < count || atomicLoad(&threadsDone) < threadsStarted) {
+		yieldThread();
+	}
+	atomicStore(&convolving, 0);
+
+	// the bands of each filter are combined in order of their rows, keeping the first of equal maximums as a single thread would
+	if (numBands > 1) {
+		for (int n = 0; n < numFilters; n++) {
+			nnInputs[n] = bandMax[n][0];
+			filterMapMaxI[n] = bandMaxI[n][0];
+			filterMapMaxJ[n] = bandMaxJ[n][0];
+			for (int band = 1; band < numBands; band++) {
+				if (bandMax[n][band] > nnInputs[n]) {
+					nnInputs[n] = bandMax[n][band];
+					filterMapMaxI[n] = bandMaxI[n][band];
+					filterMapMaxJ[n] = bandMaxJ[n][band];
+				}
+			}
+		}
+	}
+}
+
+// compute the feature maps of all convolutional filters for the current image
+void convolveColors() {
+	if (threadsUsed > 1) {
+		convolveThreads();
+		return;
+	}
+	for (int n = 0; n < numFilters; n++) {
+		convolveFilter(n, 0, height, &nnInputs[n], &filterMapMaxI[n], &filterMapMaxJ[n]);
+	}
+}
+
+// pixels and images convolved in the convolution stage being measured; the filters are read once for all of the images
+int convolvedPixels = 0;
+int convolvedImages = 1;
+
+// subtract the average of the feature map maximums over the training images from the neural network inputs; skipped images are not in the average
+void normalizeInputs() {
+	// subtract average of previous feature presence values from each neural network input, update the average as part of training
+	int totalLength = currentTrial->imagesTrained - currentTrial->imagesSkipped + 1;
+	if (training) {
+		for (int i = 0; i < numFilters; i++) {
+			nnInputTotals[i] += nnInputs[i];
+			nnInputs[i] -= nnInputTotals[i] / totalLength;
+		}
+	}
+	else {
+		totalLength = currentTrial->imagesTrained - currentTrial->imagesSkipped;
+		for (int i = 0; i < numFilters; i++) {
+			nnInputs[i] -= nnInputTotals[i] / totalLength;
+		}
+	}
+}
+
+// compute the neural network inputs of the current image: the feature map maximums, less their average over the training images
+void convolve() {
+	convolveColors();
+	convolvedPixels = numPixels;
+	convolvedImages = 1;
+	normalizeInputs();
+}
+
+// compute neural network hidden layer and outputs from inputs, weights, and biases, with the pruned weights if pruned is 1; return greatest output
+// value as the classification prediction as to the traffic sign type
+char computeLayers(char pruned) {
+	float max = -999999999.0f;
+	char maxIndex = -1;
+	Trial* t = currentTrial;
+
+	numActive = 0;
+	for (int i = 0; i < numFilters; i++) {
+		nnHidden[i] = nnBiases1[i];
+		if (pruned) {
+			for (int k = t->prunedRows1[i]; k < t->prunedRows1[i + 1]; k++) {
+				nnHidden[i] += nnInputs[t->prunedColumns1[k]] * t->prunedWeights1[k];
+			}
+		}
+		else if (useStoredParameters) {
+			for (int j = 0; j < numFilters; j++) {
+				nnHidden[i] += nnInputs[j] * loadParameter(t->storedWeights1[i][j]);
+			}
+		}
+		else {
+			for (int j = 0; j < numFilters; j++) {
+				nnHidden[i] += nnInputs[j] * nnWeights1[i][j];
+			}
+		}
+		if (nnHidden[i] < 0.0f) {
+			nnHidden[i] = 0.0f;
+		}
+		else if (nnHidden[i] > 0.0f) {
+			nnActive[numActive] = i;
+			numActive++;
+		}
+	}
+
+	// middle layer values of 0 add nothing to the outputs, so only the active ones are used
+	for (int i = 0; i < 14; i++) {
+		nnOutputs[i] = nnBiases2[i];
+		if (pruned) {
+			for (int k = t->prunedRows2[i]; k < t->prunedRows2[i + 1]; k++) {
+				nnOutputs[i] += nnHidden[t->prunedColumns2[k]] * t->prunedWeights2[k];
+			}
+		}
+		else if (useStoredParameters) {
+			for (int k = 0; k < numActive; k++) {
+				nnOutputs[i] += nnHidden[nnActive[k]] * loadParameter(t->storedWeights2[i][nnActive[k]]);
+			}
+		}
+		else {
+			for (int k = 0; k < numActive; k++) {
+				nnOutputs[i] += nnHidden[nnActive[k]] * nnWeights2[i][nnActive[k]];
+			}
+		}
+		if (nnOutputs[i] > max) {
+			max = nnOutputs[i];
+			maxIndex = i;
+		}
+	}
+
+	return maxIndex + 1;
+}
+
+// compute neural network hidden layer and outputs from inputs, weights, and biases; return greatest output value as the classification prediction as to the traffic sign type.
+// Once the trial is pruned, the pruned weights are used and each pass is timed
+char computeNN() {
+	Trial* t = currentTrial;
+	if (!t->pruned) {
+		return computeLayers(0);
+	}
+	double begin = getMilliseconds();
+	char prediction = computeLayers(1);
+	t->nnTimePruned += getMilliseconds() - begin;
+	t->passesPruned++;
+	t->activePruned += numActive;
+	return prediction;
+}
+
+// pass the current test image through the dense weights as well, timed for comparison with the pruned pass just done on the same image; return
+// its time, which is not counted in the testing time
+double compareDensePass() {
+	Trial* t = currentTrial;
+	double begin = getMilliseconds();
+	computeLayers(0);
+	double time = getMilliseconds() - begin;
+	t->nnTimeDense += time;
+	t->passesDense++;
+	t->activeDense += numActive;
+	return time;
+}
+
+// compare the magnitudes of two weights, used to sort them when pruning
+int compareMagnitudes(const void* a, const void* b) {
+	float x = fabsf(*(const float*)a);
+	float y = fabsf(*(const float*)b);
+	return x < y ? -1 : x > y;
+}
+
+// keep the weights of a rows by columns layer whose magnitudes are not among the smallest pruneFraction of them, by row in the sparse format
+void pruneLayer(float* weights, int rowLength, int rows, int columns, float* values, unsigned char* columnNumbers, int* rowStarts) {
+	int n = 0;
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < columns; j++) {
+			values[n] = weights[i * rowLength + j];
+			n++;
+		}
+	}
+	qsort(values, n, sizeof(float), compareMagnitudes);
+	int removed = (int)(pruneFraction * (float)n);
+	float threshold = removed > 0 ? fabsf(values[removed - 1]) : -1.0f;
+
+	// weights with the threshold magnitude are removed too, so at least the requested fraction is removed
+	n = 0;
+	for (int i = 0; i < rows; i++) {
+		rowStarts[i] = n;
+		for (int j = 0; j < columns; j++) {
+			if (fabsf(weights[i * rowLength + j]) > threshold) {
+				values[n] = weights[i * rowLength + j];
+				columnNumbers[n] = (unsigned char)j;
+				n++;
+			}
+		}
+	}
+	rowStarts[rows] = n;
+}
+
+// replace the current trial's trained neural network weights with the sparse pruned weights for testing; the dense weights are kept, so the
+// pruned ones are added to the trial's memory usage
+void pruneParameters() {
+	Trial* t = currentTrial;
+	pruneLayer(&nnWeights1[0][0], maxNumFilters, numFilters, numFilters, t->prunedWeights1, t->prunedColumns1, t->prunedRows1);
+	pruneLayer(&nnWeights2[0][0], maxNumFilters, 14, numFilters, t->prunedWeights2, t->prunedColumns2, t->prunedRows2);
+	t->pruned = 1;
+	t->memoryUsage += 5 * (t->prunedRows1[numFilters] + t->prunedRows2[14]) + 4 * (numFilters + 1 + 14 + 1);
+}
+
+// replace the current trial's trained 32-bit filters and weights with their 16-bit values, used for testing from then on. Each value is written
+// over the first half of its array's memory in order, so the 32-bit values not converted yet are never overwritten; the 32-bit values are lost,
+// and the trial's memory usage counts 2 bytes for each of them
+void storeParameters() {
+	Trial* t = currentTrial;
+	for (int i = 0; i < numFilters; i++) {
+		for (int j = 0; j < filterArea; j++) {
+			t->storedFilter[i][j] = storeParameter(filter[i][j]);
+		}
+		for (int j = 0; j < numFilters; j++) {
+			t->storedWeights1[i][j] = storeParameter(nnWeights1[i][j]);
+		}
+	}
+	for (int i = 0; i < 14; i++) {
+		for (int j = 0; j < numFilters; j++) {
+			t->storedWeights2[i][j] = storeParameter(nnWeights2[i][j]);
+		}
+	}
+	t->stored = 1;
+	t->memoryUsage -= 2 * (numFilters * filterArea + numFilters * numFilters + 14 * numFilters);
+	useStoredParameters = 1;
+}
+
+// once training is done, switch the current trial to the pruned weights and the 16-bit parameters if they are used; the weights are pruned first,
+// from their 32-bit values
+void prepareTestParameters() {
+	if (pruneFraction > 0.0f && !currentTrial->pruned) {
+		pruneParameters();
+	}
+	if (parameterPrecision != 0 && !currentTrial->stored) {
+		storeParameters();
+	}
+}
+
+// get the number of bytes used by the current trial's filters, weights, and biases when testing
+int getParameterBytes() {
+	int size = parameterPrecision == 0 ? 4 : 2;
+	Trial* t = currentTrial;
+	if (t->pruned) {
+		// pruned weights stay in fp32, with a 1 byte column each and the row starts
+		int weights = t->prunedRows1[numFilters] + t->prunedRows2[14];
+		return size * numFilters * filterArea + 5 * weights + 4 * (numFilters + 1 + 14 + 1) + 4 * (numFilters + 14);
+	}
+	return size * (numFilters * filterArea + numFilters * numFilters + 14 * numFilters) + 4 * (numFilters + 14);
+}
+
+// trains the CNN after a classification is done
+void train(char prediction, char correct) {
+	char pr = prediction - 1;
+	char co = correct - 1;
+
+	int colorsGreater = 0;
+
+	for (int i = 0; i < numFilters; i++) {
+		
+		// selecting the pixel color array that applies to the convolutional filter being trained
+		unsigned char* current = NULL;
+		if (i < numFiltersPerColor) {
+			current = c1;
+		}
+		else {
+			if (i < numFiltersPerColor * 2) {
+				current = c2;
+			}
+			else {
+				if (i < numFiltersPerColor * 3) {
+					current = c3;
+				}
+				else {
+					current = c4;
+				}
+			}
+		}
+		
+		// changing filter values
+		float av = 0.0f;
+		for (int j = 0; j < filterArea; j++) {
+			av += 0.0001f * (float)getPixel(current, filterMapMaxI[i] + (j / filterSize) - padding, filterMapMaxJ[i] + (j % filterSize) - padding) / (float)(imageNumber + 1);
+		}
+		for (int j = 0; j < filterArea; j++) {
+			filter[i][j] += 0.0001f * (float)getPixel(current, filterMapMaxI[i] + (j / filterSize) - padding, filterMapMaxJ[i] + (j % filterSize) - padding) / (float)(imageNumber + 1);
+			filter[i][j] -= av / (float)filterArea;
 		}
 	}
 	
@@ -830,253 +2597,1971 @@ void train(char prediction, char correct) {
 		if (nnOutputs[i] > max) {
 			max = nnOutputs[i];
 		}
-		if (nnOutputs[i] < min) {
-			min = nnOutputs[i];
+		if (nnOutputs[i] < min) {
+			min = nnOutputs[i];
+		}
+	}
+	float range = max - min;
+	if (range < 10000.0f) {
+		range = 10000.0f;
+	}
+	for (int i = 0; i < 14; i++) {
+		P[i] = (nnOutputs[i] - min) / range;
+	}
+	
+	float tr = 0.005f;
+
+	// training the second half bias values
+	for (int i = 0; i < 14; i++) {
+		if (co == i) {
+			nnBiases2[i] -= tr * ((200.0f * P[i] - 200.0f) / range);
+		}
+		else {
+			nnBiases2[i] -= tr * (2.0f * P[i] / range);
+		}
+	}
+
+	// training the second half weight values; weights from middle layer values of 0 do not change
+	int j = 0;
+	for (int i = 0; i < 14; i++) {
+		for (int k = 0; k < numActive; k++) {
+			j = nnActive[k];
+			if (co == i) {
+				nnWeights2[i][j] -= tr * (nnHidden[j] * (200.0f * P[i] - 200.0f) / range);
+			}
+			else {
+				nnWeights2[i][j] -= tr * (nnHidden[j] * 2.0f * P[i] / range);
+			}
+		}
+	}
+
+	// values to change the biases and weights on the first half of the neural network by; these depend on the ideal change in output values
+	float change[maxNumFilters] = { 0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
+	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f };
+
+	// training the first half bias values
+	for (int i = 0; i < numFilters; i++) {
+		for (int j = 0; j < 14; j++) {
+			if (co == j) {
+				change[i] += ((200.0f * P[j] - 200.0f) / range) * nnWeights2[j][i];
+			}
+			else {
+				change[i] += (2.0f * P[j] / range) * nnWeights2[j][i];
+			}
+		}
+		nnBiases1[i] -= tr * change[i];
+	}
+
+	// training the first half weight values
+	for (int h = 0; h < numFilters; h++) {
+		for (int i = 0; i < numFilters; i++) {
+			nnWeights1[h][i] -= tr * change[h] * nnInputs[i];
+		}
+	}
+}
+
+// function used to test getRand
+void testRand() {
+	seedRandom(trialRandom, baseSeed, 0);
+	printf("100 random integers from 0 to 99:\n");
+	for (int i = 0; i < 100; i++) {
+		printf("%i ", randInt(trialRandom, 0, 100));
+	}
+	printf("\n\n100 random decimals from -50 to 50:\n");
+	for (int i = 0; i < 100; i++) {
+		printf("%f ", randFloat(trialRandom, -50.0f, 100.0f));
+	}
+	printf("\n\n");
+}
+
+// function used to test getAddress
+void testAddressConstructor() {
+	for (int i = 1; i < 13; i++) {
+		for (int j = 1; j <= 5; j++) {
+			printf("%s\n", getAddress(i, j, 7, 234));
+		}
+	}
+}
+
+// function used to test whether the number of images of each sign type in each folder is as in imageCounts
+void testNumImages() {
+
+	FILE* f;
+
+	int numChallengeLevels = 5;
+	int n = 0;
+	int challengeIndex = 0;
+
+	int l = 0;
+
+	char err = 0;
+
+	// visual conditions
+	for (int i = 0; i < 13; i++) {
+		if (i == 0) {
+			numChallengeLevels = 1;
+		}
+		else {
+			numChallengeLevels = 5;
+		}
+
+		// challenge levels
+		for (int j = 1; j <= numChallengeLevels; j++) {
+
+			// sign types
+			for (int k = 1; k < 15; k++) {
+
+				l = imageCounts[k - 1]; 
+				fopen_s(&f, getAddress(i, j, k, l), "rb");
+				if (f == NULL) {
+					printf("File %s is NULL - %i %i %i %i\n", getAddress(i, j, k, l), i, j, k, l);
+					err = 1;
+					break;
+				}
+				else {
+					fclose(f);
+				}
+			}
+		}
+	}
+	if (!err) {
+		printf("All folders contain the needed images.\n");
+	}
+}
+
+// function used to test the image randomizer
+void testRandomImages() {
+	initializeImagesAll();
+	for (int i = 0; i < numTotal; i++) {
+		printf("Image %i: Condition %i, Challenge Level %i, Sign Type %i, Sign Number %i\n", i, imageConditions[i], imageChallenges[i], imageSigns[i], imageNumbers[i]);
+	}
+}
+
+// function used to test reading an image file and printing the pixel color values
+void testFileReading() {
+
+	readFile(getAddress(4, 1, 11, 52));
+
+	printf("Width: %i, Height: %i, Line Length: %i\n\n", width, height, lineLength);
+
+	printf("\n\nBGR from left to right, bottom to top:\n\n");
+
+	for (int h = 0; h < height; h++) {
+		for (int i = 0; i < lineLength; i++) {
+			printf("%i ", file[h * lineLength + i + 54]);
+		}
+		printf("\n");
+	}
+}
+
+// function used to test readArchive: the image read from its archive must match the one read from its extracted folder
+void testArchiveReading() {
+	unsigned char extracted[3][maxImageSize];
+	int extractedWidth = 0;
+	int extractedHeight = 0;
+	int differences = 0;
+	double begin = 0.0;
+
+	readFile(getAddress(4, 1, 11, 52));
+	memcpy(extracted[0], r, maxImageSize);
+	memcpy(extracted[1], g, maxImageSize);
+	memcpy(extracted[2], b, maxImageSize);
+	extractedWidth = width;
+	extractedHeight = height;
+
+	begin = getMilliseconds();
+	readArchive(4, 1, 11, 52);
+	printf("Read from %s in %fms\n", getArchiveAddress(4, 1), getMilliseconds() - begin);
+	for (int i = 0; i < numPixels; i++) {
+		if (r[i] != extracted[0][i] || g[i] != extracted[1][i] || b[i] != extracted[2][i]) {
+			differences++;
+		}
+	}
+	printf("Width: %i (%i extracted), Height: %i (%i extracted), Pixels different: %i\n\n", width, extractedWidth, height, extractedHeight, differences);
+}
+
+// function used to test convert
+void testConversions() {
+	r[0] = 0; g[0] = 20; b[0] = 20;
+	r[1] = 40; g[1] = 20; b[1] = 20;
+	r[2] = 60; g[2] = 0; b[2] = 20;
+	r[3] = 200; g[3] = 80; b[3] = 80;
+	r[4] = 80; g[4] = 80; b[4] = 150;
+	r[5] = 255; g[5] = 20; b[5] = 255;
+	r[6] = 0; g[6] = 90; b[6] = 0;
+	r[7] = 0; g[7] = 0; b[7] = 0;
+	r[8] = 129; g[8] = 255; b[8] = 183;
+
+	height = 3;
+	width = 3;
+	printf("Nine example colors converted to eight color models:\n\n");
+	for (char i = 0; i < 8; i++) {
+		currentColorModel = i;
+		convert();
+		for (int i = 0; i < 9; i++) {
+			printf("R %i, G %i, B %i, C1 %i, C2 %i, C3 %i, C4 %i\n", r[i], g[i], b[i], c1[i], c2[i], c3[i], c4[i]);
+		}
+		printf("\n\n");
+	}
+}
+
+// function used to test resizeImage
+void testResize() {
+	printf("A 4x4 red gradient resized to 2x2 and 6x6 with the area and bilinear filters:\n\n");
+	for (char k = 0; k < 2; k++) {
+		for (int t = 2; t <= 6; t += 4) {
+			width = 4;
+			height = 4;
+			numPixels = 16;
+			for (int i = 0; i < 4; i++) {
+				for (int j = 0; j < 4; j++) {
+					r[i * width + j] = (unsigned char)(i * 64 + j * 16);
+				}
+			}
+			resizeFilter = k;
+			targetWidth = t;
+			targetHeight = t;
+			resizeImage();
+			for (int i = 0; i < height; i++) {
+				for (int j = 0; j < width; j++) {
+					printf("%3i ", r[i * width + j]);
+				}
+				printf("\n");
+			}
+			printf("\n");
+		}
+	}
+}
+
+// function used to test that every convolution kernel, and row bands combined, match the generic loop for every filter size, on images larger and
+// smaller than the filter and with black and colored surroundings
+void testConvolution() {
+	float maxima[numKernels + 1];
+	int maxI[numKernels + 1];
+	int maxJ[numKernels + 1];
+	char savedKernel = kernel;
+
+	seedRandom(trialRandom, baseSeed, 0);
+	numFiltersPerColor = 1;
+	for (int s = 0; s < 2; s++) {
+		width = s == 0 ? 40 : 6;
+		height = s == 0 ? 30 : 5;
+		numPixels = width * height;
+		for (filterSize = 3; filterSize <= maxFilterSize; filterSize += 2) {
+			filterArea = filterSize * filterSize;
+			padding = filterSize / 2;
+			for (int i = 0; i <= numPixels; i++) {
+				c1[i] = (unsigned char)randInt(trialRandom, 0, 256);
+			}
+			// the large image has black surroundings and the small image does not
+			if (s == 0) {
+				c1[numPixels] = 0;
+			}
+			for (int i = 0; i < filterArea; i++) {
+				filter[0][i] = randFloat(trialRandom, -5.0f, 10.0f);
+			}
+
+			planeVersion++;
+
+			for (int k = 0; k < numKernels; k++) {
+				kernel = k;
+				convolveFilter(0, 0, height, &maxima[k], &maxI[k], &maxJ[k]);
+			}
+
+			// the unrolled kernel again, over 3 bands of rows combined as the threads combine them
+			kernel = 0;
+			maxima[numKernels] = -999999999.0f;
+			for (int band = 0; band < 3; band++) {
+				convolveFilter(0, band * height / 3, (band + 1) * height / 3, &bandMax[0][band], &bandMaxI[0][band], &bandMaxJ[0][band]);
+				if (bandMax[0][band] > maxima[numKernels]) {
+					maxima[numKernels] = bandMax[0][band];
+					maxI[numKernels] = bandMaxI[0][band];
+					maxJ[numKernels] = bandMaxJ[0][band];
+				}
+			}
+
+			printf("%ix%i image, size %ix%i:", width, height, filterSize, filterSize);
+			for (int k = 0; k <= numKernels; k++) {
+				printf(" %s %f at (%i, %i)%s", k < numKernels ? kernelNames[k] : "bands", maxima[k], maxI[k], maxJ[k], k < numKernels ? "," : "\n");
+			}
+		}
+	}
+	kernel = savedKernel;
+	printf("\n");
+}
+
+// function used to test the conversions to and from 16-bit parameter storage
+void testParameterPrecision() {
+	float values[8] = { 0.0f, 1.0f, -0.333333f, 3.14159265f, 65504.0f, 100000.0f, 0.00001f, -0.0000001f };
+	printf("Value, fp16, bf16:\n");
+	for (int i = 0; i < 8; i++) {
+		printf("%.9g, %.9g, %.9g\n", values[i], halfToFloat(floatToHalf(values[i])), bfloatToFloat(floatToBfloat(values[i])));
+	}
+	printf("\n");
+}
+
+// test that pruning a small layer keeps the weights with the largest magnitudes in the whole layer, stored row by row
+void testPruning() {
+	float weights[3][4] = { { 0.5f, -0.1f, 0.0f, 2.0f }, { -3.0f, 0.2f, 0.3f, -0.05f }, { 1.0f, -1.0f, 0.01f, 0.4f } };
+	float values[12];
+	unsigned char columns[12];
+	int rows[4];
+	float fraction = pruneFraction;
+	pruneFraction = 0.5f;
+	pruneLayer(&weights[0][0], 4, 3, 4, values, columns, rows);
+	pruneFraction = fraction;
+	for (int i = 0; i < 3; i++) {
+		printf("Row %i:", i);
+		for (int k = rows[i]; k < rows[i + 1]; k++) {
+			printf(" %i (%f)", columns[k], values[k]);
 		}
+		printf("\n");
 	}
-	float range = max - min;
-	if (range < 10000.0f) {
-		range = 10000.0f;
+	printf("%i/12 weights kept\n\n", rows[3]);
+}
+
+// trial a stored model is read into, used as the source of warm starts
+Trial modelTrial;
+
+// get the address of the model file of a configuration in the working folder
+void getModelAddress(char* address, int length, char size, int count, char colorModel) {
+	snprintf(address, length, "model-%ix%i-%i-%i.bin", size, size, count, colorModel + 1);
+}
+
+// fill the settings a trial's trained parameters depend on into the first 6 and last 5 values of a model file header: the sample, the filter
+// configuration, the image selection, the image resizing (0s without it), and the training images held out for early stopping (0 without it)
+void getModelSettings(int* header, char size, int count, char colorModel) {
+	header[0] = modelMagic;
+	header[1] = numTotal;
+	header[2] = (int)baseSeed;
+	header[3] = size;
+	header[4] = count;
+	header[5] = colorModel;
+	header[8] = imageSelection;
+	header[9] = resizeImages ? targetWidth : 0;
+	header[10] = resizeImages ? targetHeight : 0;
+	header[11] = resizeImages ? resizeFilter : 0;
+	header[12] = earlyStopping ? numValidation : 0;
+}
+
+// write the trained parameters of a trial to a model file, with the settings they depend on, the number of images it was trained on, the filter count
+// of the model it started from, the number of images it and the models it started from were trained on in all, and the number of its training images
+// skipped as too large
+void writeModel(Trial* t, char* address) {
+	int header[modelHeaderSize];
+	getModelSettings(header, t->filterSize, t->numFilters, t->colorModel);
+	header[6] = t->imagesTrained;
+	header[7] = t->warmStartFilters;
+	header[13] = t->imagesTrained + t->warmStartChain;
+	header[14] = t->imagesSkipped;
+	int count = t->numFilters;
+	int area = t->filterSize * t->filterSize;
+	FILE* fp;
+	fopen_s(&fp, address, "wb");
+	if (fp == NULL) {
+		printf("Couldn't write file %s\n", address);
+		return;
+	}
+	fwrite(header, sizeof(int), modelHeaderSize, fp);
+	for (int i = 0; i < count; i++) {
+		fwrite(t->filter[i], sizeof(float), area, fp);
+	}
+	for (int i = 0; i < count; i++) {
+		fwrite(t->nnWeights1[i], sizeof(float), count, fp);
+	}
+	fwrite(t->nnBiases1, sizeof(float), count, fp);
+	for (int i = 0; i < 14; i++) {
+		fwrite(t->nnWeights2[i], sizeof(float), count, fp);
+	}
+	fwrite(t->nnBiases2, sizeof(float), 14, fp);
+	fwrite(t->nnInputTotals, sizeof(float), count, fp);
+	fclose(fp);
+}
+
+// save the trained parameters of a trial to its model file
+void saveModel(Trial* t) {
+	char address[64];
+	getModelAddress(address, sizeof(address), t->filterSize, t->numFilters, t->colorModel);
+	writeModel(t, address);
+}
+
+// read the model file of a configuration into a trial, if there is one saved with the same sample and settings; returns 1 if it was read
+int loadModel(Trial* t, char size, int count, char colorModel) {
+	char address[64];
+	int header[modelHeaderSize];
+	int expected[modelHeaderSize];
+	int area = size * size;
+	size_t read = 0;
+	FILE* fp;
+	getModelAddress(address, sizeof(address), size, count, colorModel);
+	fopen_s(&fp, address, "rb");
+	if (fp == NULL) {
+		return 0;
+	}
+	getModelSettings(expected, size, count, colorModel);
+	if (fread(header, sizeof(int), modelHeaderSize, fp) != modelHeaderSize || memcmp(header, expected, 6 * sizeof(int)) != 0
+		|| memcmp(&header[8], &expected[8], 5 * sizeof(int)) != 0) {
+		fclose(fp);
+		return 0;
+	}
+	for (int i = 0; i < count; i++) {
+		read += fread(t->filter[i], sizeof(float), area, fp);
+	}
+	for (int i = 0; i < count; i++) {
+		read += fread(t->nnWeights1[i], sizeof(float), count, fp);
+	}
+	read += fread(t->nnBiases1, sizeof(float), count, fp);
+	for (int i = 0; i < 14; i++) {
+		read += fread(t->nnWeights2[i], sizeof(float), count, fp);
+	}
+	read += fread(t->nnBiases2, sizeof(float), 14, fp);
+	read += fread(t->nnInputTotals, sizeof(float), count, fp);
+	fclose(fp);
+	if (read != (size_t)(count * area + count * count + count + 14 * count + 14 + count)) {
+		return 0;
+	}
+	t->filterSize = size;
+	t->numFilters = count;
+	t->colorModel = colorModel;
+	t->imagesTrained = header[6];
+	t->warmStartFilters = header[7];
+	t->warmStartChain = header[13] - header[6];
+	t->imagesSkipped = header[14];
+	return 1;
+}
+
+// position of filter (and middle layer value) number n of a model with count filters in a model of the current color model with more filters; the
+// filters of each color keep their place at the start of that color's filters
+int getWarmStartPosition(int n, int count, int largerCount) {
+	int colors = getNumColors();
+	return n / (count / colors) * (largerCount / colors) + n % (count / colors);
+}
+
+// with warmStart, copy the parameters of the saved model with the most filters below the current trial's, for the same filter size and color model,
+// into the trial: its filters, the middle layer weights between them, their biases, and their output layer weights; the rest keep their random values
+void warmStartTrial(Trial* t) {
+	int count = 0;
+	int x = 0;
+	for (count = t->numFilters - 24; count > 0; count -= 24) {
+		if (loadModel(&modelTrial, t->filterSize, count, t->colorModel)) {
+			break;
+		}
+	}
+	if (count <= 0) {
+		return;
+	}
+	for (int i = 0; i < count; i++) {
+		x = getWarmStartPosition(i, count, t->numFilters);
+		memcpy(t->filter[x], modelTrial.filter[i], sizeof(float) * t->filterSize * t->filterSize);
+		for (int j = 0; j < count; j++) {
+			t->nnWeights1[x][getWarmStartPosition(j, count, t->numFilters)] = modelTrial.nnWeights1[i][j];
+		}
+		t->nnBiases1[x] = modelTrial.nnBiases1[i];
+		for (int k = 0; k < 14; k++) {
+			t->nnWeights2[k][x] = modelTrial.nnWeights2[k][i];
+		}
+	}
+	for (int k = 0; k < 14; k++) {
+		t->nnBiases2[k] = modelTrial.nnBiases2[k];
+	}
+	t->warmStartFilters = count;
+	t->warmStartImages = modelTrial.imagesTrained;
+	t->warmStartChain = modelTrial.imagesTrained + modelTrial.warmStartChain;
+}
+
+// save the models of the trials of a group once they are trained, leaving out trials eliminated by successive halving
+void saveTrialModels(Trial* group, int count) {
+	if (!saveModels && !warmStart) {
+		return;
+	}
+	for (int t = 0; t < count; t++) {
+		if (group[t].eliminated == 0) {
+			saveModel(&group[t]);
+		}
+	}
+}
+
+// make a trial the current one: point the parameter arrays at its parameters and set its filter size, filter count, and color model
+void selectTrial(Trial* t) {
+	currentTrial = t;
+	useStoredParameters = t->stored;
+	filter = t->filter;
+	nnWeights1 = t->nnWeights1;
+	nnWeights2 = t->nnWeights2;
+	nnBiases1 = t->nnBiases1;
+	nnBiases2 = t->nnBiases2;
+	nnInputTotals = t->nnInputTotals;
+
+	filterSize = t->filterSize;
+	filterArea = filterSize * filterSize;
+	halfFilterArea = filterArea / 2;
+	padding = filterSize / 2;
+
+	numFilters = t->numFilters;
+	currentColorModel = t->colorModel;
+	numFiltersPerColor = numFilters / getNumColors();
+
+	kernel = tuneKernels ? kernelChoices[(int)filterSize][numFilters][(int)getNumColors()] : 0;
+	if (kernel < 0) {
+		kernel = 0;
+	}
+}
+
+// set up a trial with the given configuration and fill its parameters from its own random number stream
+void startTrial(Trial* t, char size, int count, char colorModel) {
+	t->filterSize = size;
+	t->numFilters = count;
+	t->colorModel = colorModel;
+	t->stored = 0;
+	t->pruned = 0;
+	t->passesDense = 0;
+	t->passesPruned = 0;
+	t->activeDense = 0;
+	t->activePruned = 0;
+	t->nnTimeDense = 0.0;
+	t->nnTimePruned = 0.0;
+	t->imagesTrained = 0;
+	t->imagesSkipped = 0;
+	t->stopped = 0;
+	t->bestValidation = -1.0f;
+	t->validationsWithoutImprovement = 0;
+	t->validation = -1.0f;
+	t->imagesValidated = 0;
+	t->eliminated = 0;
+	for (int i = 0; i < numStages; i++) {
+		t->stageTime[i] = 0.0;
+		t->stageFlops[i] = 0.0;
+		t->stageBytes[i] = 0.0;
+		for (int j = 0; j < numCounters; j++) {
+			t->stageCounters[i][j] = 0;
+		}
+	}
+	t->testingStopped = 0;
+	t->accuracyLow = 0.0f;
+	t->accuracyHigh = 100.0f;
+	t->imagesCorrect = 0;
+	t->imagesClassified = 0;
+	t->timeTraining = 0.0;
+	t->timeTesting = 0.0;
+
+	selectTrial(t);
+	seedRandom(trialRandom, baseSeed, getTrialStream());
+	randomizeParameters();
+	t->warmStartFilters = 0;
+	t->warmStartImages = 0;
+	t->warmStartChain = 0;
+	if (warmStart) {
+		warmStartTrial(t);
+	}
+
+	t->memoryUsage = 4 * (numFilters * filterArea + numFilters * (numFilters + 14 + 3) + (2 * 14)) + (3 + getNumColors()) * maxImageSize + maxFileSize;
+	if (resizeImages) {
+		t->memoryUsage += 3 * maxImageSize;
+	}
+	if (kernel == 2) {
+		t->memoryUsage += 4 * 2 * maxImageSize;
+	}
+	if (readArchives) {
+		t->memoryUsage += maxFileSize;
+	}
+	if (batchSize > 1) {
+		t->memoryUsage += batchSize * ((3 + getNumColors()) * maxImageSize + 12 * numFilters) + 4 * batchFilterBlock * filterArea;
+	}
+}
+
+// test warm starts: print where the filters of a 24-filter model go in a 72-filter model for each color model, then check that a saved model reads
+// back the same and that a larger trial starts from it
+void testWarmStart() {
+	char warm = warmStart;
+	int differences = 0;
+	for (char c = 0; c < 8; c++) {
+		currentColorModel = c;
+		printf("Color Model #%i:", c + 1);
+		for (int n = 0; n < 24; n++) {
+			printf(" %i", getWarmStartPosition(n, 24, 72));
+		}
+		printf("\n");
+	}
+
+	warmStart = 0;
+	startTrial(&trials[0], 3, 24, 3);
+	trials[0].imagesTrained = 100;
+	saveModel(&trials[0]);
+	warmStart = 1;
+	startTrial(&trials[1], 3, 48, 3);
+	warmStart = warm;
+	for (int n = 0; n < 24; n++) {
+		int x = getWarmStartPosition(n, 24, 48);
+		differences += memcmp(trials[1].filter[x], trials[0].filter[n], sizeof(float) * 9) != 0;
+		differences += trials[1].nnWeights2[5][x] != trials[0].nnWeights2[5][n];
+		differences += trials[1].nnWeights1[x][getWarmStartPosition(23 - n, 24, 48)] != trials[0].nnWeights1[n][23 - n];
+	}
+	printf("Warm start from %i filters trained on %i images, %i differences\n\n", trials[1].warmStartFilters, trials[1].warmStartImages, differences);
+}
+
+// read the image with the given position in the sample into the RGB arrays
+void readImage(int n) {
+	// get address of image, read all file content and store image pixel color data
+	if (readArchives) {
+		readArchive(imageConditions[n], imageChallenges[n], imageSigns[n], imageNumbers[n]);
+	}
+	else {
+		readFile(getAddress(imageConditions[n], imageChallenges[n], imageSigns[n], imageNumbers[n]));
+	}
+	// optionally resample the image to the target resolution
+	if (resizeImages) {
+		resizeImage();
+	}
+}
+
+// names of the measured stages
+char* stageNames[numStages] = { "convolve", "computeNN", "train" };
+
+// counter values and time at the start of the stage being measured
+long long stageStartCounters[numCounters];
+double stageStartTime = 0.0;
+
+// start measuring a stage of the current trial
+void beginStage() {
+	if (!measureStages) {
+		return;
+	}
+	if (!countersOpened[0]) {
+		openCounters(0);
+	}
+	readCounters(stageStartCounters);
+	stageStartTime = getMilliseconds();
+}
+
+// finish measuring a stage of the current trial, adding its time, counters, and analytic operation and byte counts to the trial's totals;
+// byte counts are the data each stage must at least read and write once
+void endStage(int stage) {
+	if (!measureStages) {
+		return;
+	}
+	double time = getMilliseconds() - stageStartTime;
+	long long values[numCounters];
+	readCounters(values);
+
+	Trial* t = currentTrial;
+	t->stageTime[stage] += time;
+	for (int i = 0; i < numCounters; i++) {
+		t->stageCounters[stage][i] += values[i] - stageStartCounters[i];
+	}
+
+	double nf = (double)numFilters;
+	double area = (double)filterArea;
+	switch (stage) {
+	case 0:
+		// a multiply and an add per filter value per pixel per filter; each color array, the filters, and the outputs once
+		t->stageFlops[0] += 2.0 * convolvedPixels * nf * area;
+		t->stageBytes[0] += (double)getNumColors() * convolvedPixels + 4.0 * nf * area + 12.0 * nf * convolvedImages;
+		break;
+	case 1:
+		// a multiply and an add per weight; the weights, biases, inputs, hidden values, and outputs once
+		t->stageFlops[1] += 2.0 * (nf * nf + 14.0 * nf);
+		t->stageBytes[1] += 4.0 * (nf * nf + 14.0 * nf + 3.0 * nf + 28.0);
+		break;
+	case 2:
+		// 6 operations per filter value, 4 per output weight and its backward term, 3 per hidden weight; filters and weights read and written once
+		t->stageFlops[2] += 6.0 * nf * area + 8.0 * 14.0 * nf + 3.0 * nf * nf;
+		t->stageBytes[2] += 8.0 * (nf * area + nf * nf + 14.0 * nf) + area * nf;
+		break;
+	}
+}
+
+// display the measurements of each stage of a trial; the counters are added up over all threads, so the IPC is that of the threads' cycles together
+void printStages(Trial* t) {
+	double seconds = 0.0;
+	long long* c;
+	for (int stage = 0; stage < numStages; stage++) {
+		seconds = t->stageTime[stage] / 1000.0;
+		c = t->stageCounters[stage];
+		printf("Stage %s: %fms on %i thread%s, %f GFLOP/s, %f FLOP/byte", stageNames[stage], t->stageTime[stage], stage == 0 ? threadsUsed : 1,
+		stage == 0 && threadsUsed > 1 ? "s" : "", seconds > 0.0 ? t->stageFlops[stage] / seconds / 1000000000.0 : 0.0, t->stageBytes[stage] > 0.0 ? t->stageFlops[stage] / t->stageBytes[stage] : 0.0);
+		if (c[0] > 0) {
+			printf(", %f IPC, %lli cache misses, %lli branch misses (%f per 1000 instructions)", (double)c[1] / (double)c[0], c[2], c[3], 1000.0 * (double)c[3] / (double)c[1]);
+		}
+		printf("\n");
+	}
+}
+
+// check whether sequential testing looks at the accuracy interval after the given number of test images
+char isTestCheck(int n) {
+	if (n == numTotal - numTraining) {
+		return 1;
+	}
+	if (n < minTestImages || n % minTestImages != 0) {
+		return 0;
+	}
+	n /= minTestImages;
+	return (n & (n - 1)) == 0;
+}
+
+// set checkZ so the intervals of all checks of the test images hold together with confidenceLevel: each check gets an equal part of the error
+void prepareSequentialChecks() {
+	int checks = 0;
+	for (int n = minTestImages > 0 ? minTestImages : 1; n < numTotal - numTraining; n *= 2) {
+		checks++;
+	}
+	checks++;
+	double alpha = (1.0 - confidenceLevel) / checks;
+	double low = 0.0;
+	double high = 10.0;
+	double z = 0.0;
+
+	// the two-sided error of z standard deviations is erfc(z / sqrt(2)), which falls as z grows
+	for (int i = 0; i < 60; i++) {
+		z = (low + high) / 2.0;
+		if (erfc(z / sqrt(2.0)) > alpha) {
+			low = z;
+		}
+		else {
+			high = z;
+		}
+	}
+	checkZ = (float)z;
+}
+
+// update the Wilson score interval of a trial's accuracy from its test results so far
+void updateAccuracyInterval(Trial* t) {
+	float n = (float)t->imagesClassified;
+	float p = (float)t->imagesCorrect / n;
+	float z2 = checkZ * checkZ;
+	float center = (p + z2 / (2.0f * n)) / (1.0f + z2 / n);
+	float half = checkZ * sqrtf(p * (1.0f - p) / n + z2 / (4.0f * n * n)) / (1.0f + z2 / n);
+	t->accuracyLow = 100.0f * (center - half);
+	t->accuracyHigh = 100.0f * (center + half);
+}
+
+// add a line with the configuration and results of a tested trial to resultsFile, starting the file with the column names if it is new; the image
+// selection, resizing, and early stopping split are written as in model files (see getModelSettings)
+void saveResult(Trial* t) {
+	int settings[modelHeaderSize];
+	FILE* fp;
+	fopen_s(&fp, resultsFile, "r");
+	if (fp != NULL) {
+		fclose(fp);
+		fopen_s(&fp, resultsFile, "a");
+	}
+	else {
+		fopen_s(&fp, resultsFile, "w");
+		if (fp != NULL) {
+			fprintf(fp, "filterSize,numFilters,colorModel,imagesCorrect,imagesClassified,accuracy,trainingMs,testingMs,memoryUsage,imagesTrained,"
+				"warmStartFilters,parameterPrecision,pruneFraction,numTotal,seed,imageSelection,resizedWidth,resizedHeight,resizeFilter,validationImages\n");
+		}
+	}
+	if (fp == NULL) {
+		printf("Couldn't write file %s\n", resultsFile);
+		return;
+	}
+	getModelSettings(settings, t->filterSize, t->numFilters, t->colorModel);
+	fprintf(fp, "%i,%i,%i,%i,%i,%f,%f,%f,%i,%i,%i,%i,%f,%i,%u,%i,%i,%i,%i,%i\n", t->filterSize, t->numFilters, t->colorModel + 1, t->imagesCorrect,
+		t->imagesClassified, 100.0f * (float)t->imagesCorrect / (float)t->imagesClassified, t->timeTraining, t->timeTesting, t->memoryUsage,
+		t->imagesTrained, t->warmStartFilters, parameterPrecision, pruneFraction, numTotal, baseSeed, settings[8], settings[9], settings[10], settings[11],
+		settings[12]);
+	fclose(fp);
+}
+
+// display the results of a finished trial
+void printResults(Trial* t) {
+	selectTrial(t);
+	int timeTraining = (int)(t->timeTraining + 0.5);
+	int timeTesting = (int)(t->timeTesting + 0.5);
+	int timeTotal = timeTraining + timeTesting;
+	printf("%i Filters of Size %ix%i, Color Model #%i: %i/%i (%f%%)\nTraining Duration: %ims\nTesting Duration: %ims\nTotal Duration: %ims (%fms per image)\nTotal Memory Usage: %i bytes\n",
+	numFilters, filterSize, filterSize, currentColorModel + 1, t->imagesCorrect, t->imagesClassified, 100.0f * (float)t->imagesCorrect / (float)t->imagesClassified, timeTraining, timeTesting, timeTotal, ((float)timeTotal) / (float)(t->imagesTrained + t->imagesClassified), t->memoryUsage);
+	printf("Random Seed: %u, Trial #%u\n", baseSeed, getTrialNumber() + 1);
+	if (t->imagesSkipped > 0) {
+		printf("Skipped Images: %i of the %i training images, too large for the arrays\n", t->imagesSkipped, t->imagesTrained);
+	}
+	if (resizeImages) {
+		printf("Image Resolution: %ix%i (%s)\n", targetWidth, targetHeight, resizeFilter == 0 ? "area" : "bilinear");
+	}
+	else {
+		printf("Image Resolution: original\n");
+	}
+	if (t->warmStartFilters > 0) {
+		char address[64];
+		getModelAddress(address, sizeof(address), filterSize, t->warmStartFilters, currentColorModel);
+		printf("Warm Start: %i of %i filters and their weights from the %i-filter model %s, trained on %i images (%i with the models it started from)\n",
+		t->warmStartFilters, numFilters, t->warmStartFilters, address, t->warmStartImages, t->warmStartChain);
+	}
+	else if (warmStart) {
+		printf("Warm Start: none (random parameters)\n");
+	}
+	if (earlyStopping) {
+		// the time saved is estimated from the average time per trained image, including validation
+		printf("Early Stopping: trained on %i/%i images (%s), best validation accuracy %f%% on %i images, about %ims saved\n",
+		t->imagesTrained, numTraining - numValidation, t->stopped ? "stopped" : "not stopped", t->bestValidation, numValidation,
+		(int)(t->timeTraining / t->imagesTrained * (numTraining - numValidation - t->imagesTrained) + 0.5));
+	}
+	if (pruneFraction > 0.0f) {
+		// the dense and pruned passes are both made on each test image
+		printf("Pruning: %i/%i middle layer weights and %i/%i output layer weights kept, %fms per forward pass dense and %fms pruned on %i test images\n",
+		t->prunedRows1[numFilters], numFilters * numFilters, t->prunedRows2[14], 14 * numFilters, t->nnTimeDense / t->passesDense,
+		t->nnTimePruned / t->passesPruned, t->passesPruned);
+		printf("Active Middle Layer Values: %f%% dense and %f%% pruned\n", 100.0f * (float)t->activeDense / (float)(numFilters * t->passesDense),
+		100.0f * (float)t->activePruned / (float)(numFilters * t->passesPruned));
+	}
+	if (parameterPrecision != 0 || pruneFraction > 0.0f) {
+		printf("Parameter Storage: %s, %i bytes for testing (%i bytes in fp32)\n", precisionNames[(int)parameterPrecision], getParameterBytes(),
+		4 * (numFilters * filterArea + numFilters * numFilters + 14 * numFilters) + 4 * (numFilters + 14));
+	}
+	if (measureStages) {
+		printStages(t);
+	}
+	if (sequentialTesting) {
+		printf("Sequential Testing: %.0f%% interval %f%% to %f%% from %i/%i test images (%s)\n", 100.0f * confidenceLevel,
+		t->accuracyLow, t->accuracyHigh, t->imagesClassified, numTotal - numTraining,
+		t->testingStopped == 1 ? "interval narrow enough" : t->testingStopped == 2 ? "worse than best trial" : "all images tested");
+	}
+	printf("\n");
+	if (saveResults) {
+		saveResult(t);
+	}
+}
+
+// convert, convolve, and classify the current image with the current trial, returning the prediction
+char classifyImage() {
+	char prediction = -1;
+	// convert image pixel color data to this trial's color model
+	convert();
+	// convolve the image pixels
+	beginStage();
+	convolve();
+	endStage(0);
+	// use the neural network to compute the classification prediction
+	beginStage();
+	prediction = computeNN();
+	endStage(1);
+	return prediction;
+}
+
+// the RGB arrays and size of each image of the batch, and its color arrays in the current trial's color model
+unsigned char batchRGB[maxBatchSize][3][maxImageSize];
+unsigned char batchColors[maxBatchSize][4][maxImageSize];
+int batchWidths[maxBatchSize];
+int batchHeights[maxBatchSize];
+
+// feature map maximums and their positions for each image of the batch
+float batchInputs[maxBatchSize][maxNumFilters];
+int batchMaxI[maxBatchSize][maxNumFilters];
+int batchMaxJ[maxBatchSize][maxNumFilters];
+
+// the block of filters being applied to the batch, converted from 16-bit storage if the trial is tested with it, and the same values arranged by
+// filter position, with the value of every filter of the block at each position together (0 for the filters past the end of the block)
+float batchFilters[batchFilterBlock][maxFilterArea];
+float blockTaps[maxFilterArea][batchFilterBlock];
+
+// keep the image in the RGB arrays as image number k of the batch
+void storeBatchImage(int k) {
+	memcpy(batchRGB[k][0], r, numPixels + 1);
+	memcpy(batchRGB[k][1], g, numPixels + 1);
+	memcpy(batchRGB[k][2], b, numPixels + 1);
+	batchWidths[k] = width;
+	batchHeights[k] = height;
+}
+
+// convert image number k of the batch to the current trial's color model and keep its color arrays
+void convertBatchImage(int k) {
+	width = batchWidths[k];
+	height = batchHeights[k];
+	numPixels = width * height;
+	memcpy(r, batchRGB[k][0], numPixels + 1);
+	memcpy(g, batchRGB[k][1], numPixels + 1);
+	memcpy(b, batchRGB[k][2], numPixels + 1);
+	convert();
+	memcpy(batchColors[k][0], c1, numPixels + 1);
+	memcpy(batchColors[k][1], c2, numPixels + 1);
+	memcpy(batchColors[k][2], c3, numPixels + 1);
+	memcpy(batchColors[k][3], c4, numPixels + 1);
+}
+
+// point the border kernel at filter number n of the block starting with filter number first, and at its maximum for image number k of the batch
+void selectBlockFilter(int k, int n, int first) {
+	F = batchFilters[n - first];
+	mapMax = &batchInputs[k][n];
+	mapMaxI = &batchMaxI[k][n];
+	mapMaxJ = &batchMaxJ[k][n];
+}
+
+// compute the feature maps of filters first up to end for image number k of the batch, whose pixel color array is a. Inside the image, each pixel
+// under the filter is read once for the whole block, and the sums of every filter of the block are kept together so the compiler can compute them
+// with vector instructions; each sum adds its terms in the same order as the other kernels, and each feature map is scanned in the same order, so
+// the maximums and their positions are the same. Pixels within half a filter of the edges use convolveBorder
+void convolveBlock(unsigned char* a, int k, int first, int end) {
+	float totals[batchFilterBlock];
+	float pixel = 0.0f;
+	unsigned char* line = NULL;
+	float* taps = NULL;
+
+	for (int n = first; n < end; n++) {
+		batchInputs[k][n] = -999999999.0f;
+	}
+	for (int i = 0; i < height; i++) {
+		for (int n = first; n < end; n++) {
+			selectBlockFilter(k, n, first);
+			convolveBorder(a, i, 0, padding < width ? padding : width);
+		}
+		if (i >= padding && i < height - padding) {
+			for (int j = padding; j < width - padding; j++) {
+				for (int f = 0; f < batchFilterBlock; f++) {
+					totals[f] = 0.0f;
+				}
+				for (int y = 0; y < filterSize; y++) {
+					line = a + (i + y - padding) * width + j - padding;
+					taps = blockTaps[y * filterSize];
+					for (int c = 0; c < filterSize; c++) {
+						pixel = (float)line[c];
+						for (int f = 0; f < batchFilterBlock; f++) {
+							totals[f] += taps[c * batchFilterBlock + f] * pixel;
+						}
+					}
+				}
+				for (int n = first; n < end; n++) {
+					if (totals[n - first] > batchInputs[k][n]) {
+						batchInputs[k][n] = totals[n - first];
+						batchMaxI[k][n] = i;
+						batchMaxJ[k][n] = j;
+					}
+				}
+			}
+		}
+		else {
+			for (int n = first; n < end; n++) {
+				selectBlockFilter(k, n, first);
+				convolveBorder(a, i, padding, width - padding);
+			}
+		}
+		for (int n = first; n < end; n++) {
+			selectBlockFilter(k, n, first);
+			convolveBorder(a, i, width - padding > padding ? width - padding : padding, width);
+		}
+	}
+}
+
+// compute the feature maps of all convolutional filters for the first count images of the batch, with the same results as convolveColors; the
+// filters are taken in blocks of up to batchFilterBlock filters of one color, and each block stays in the cache while it is applied to every image
+void convolveBatch(int count) {
+	int end = 0;
+	int color = 0;
+	for (int first = 0; first < numFilters; first = end) {
+		color = first / numFiltersPerColor < 3 ? first / numFiltersPerColor : 3;
+		end = first + batchFilterBlock;
+		if (color < 3 && end > (color + 1) * numFiltersPerColor) {
+			end = (color + 1) * numFiltersPerColor;
+		}
+		if (end > numFilters) {
+			end = numFilters;
+		}
+		for (int n = first; n < end; n++) {
+			memcpy(batchFilters[n - first], loadFilter(n), sizeof(float) * filterArea);
+		}
+		for (int tap = 0; tap < filterArea; tap++) {
+			for (int f = 0; f < batchFilterBlock; f++) {
+				blockTaps[tap][f] = first + f < end ? batchFilters[f][tap] : 0.0f;
+			}
+		}
+
+		for (int k = 0; k < count; k++) {
+			width = batchWidths[k];
+			height = batchHeights[k];
+			numPixels = width * height;
+			convolveBlock(batchColors[k][color], k, first, end);
+		}
+	}
+}
+
+// convert and convolve the first count images of the batch with the current trial; the convolution counts as one stage for the whole batch
+void convolveBatchImages(int count) {
+	convolvedPixels = 0;
+	for (int k = 0; k < count; k++) {
+		convertBatchImage(k);
+		convolvedPixels += numPixels;
+	}
+	convolvedImages = count;
+	beginStage();
+	convolveBatch(count);
+	endStage(0);
+}
+
+// classify image number k of the batch with the current trial from its feature map maximums, returning the prediction
+char classifyBatchImage(int k) {
+	char prediction = -1;
+	for (int n = 0; n < numFilters; n++) {
+		nnInputs[n] = batchInputs[k][n];
+		filterMapMaxI[n] = batchMaxI[k][n];
+		filterMapMaxJ[n] = batchMaxJ[k][n];
+	}
+	normalizeInputs();
+	beginStage();
+	prediction = computeNN();
+	endStage(1);
+	return prediction;
+}
+
+// measure the accuracy of every trial of a group that is still training on the validation images, leaving out skipped images; the time taken counts
+// as training time
+void measureValidation(Trial* group, int count) {
+	int active = 0;
+	int images = 0;
+	double begin = 0.0;
+	double shared = 0.0;
+	for (int t = 0; t < count; t++) {
+		if (!group[t].stopped) {
+			group[t].validation = 0.0f;
+			active++;
+		}
+	}
+	if (active == 0) {
+		return;
+	}
+	training = 0;
+	for (int n = numTraining - numValidation; n < numTraining; n++) {
+		begin = getMilliseconds();
+		readImage(n);
+		shared = (getMilliseconds() - begin) / active;
+		if (imageSkipped) {
+			continue;
+		}
+		images++;
+		for (int t = 0; t < count; t++) {
+			if (group[t].stopped) {
+				continue;
+			}
+			begin = getMilliseconds();
+			selectTrial(&group[t]);
+			if (classifyImage() == imageSigns[n]) {
+				group[t].validation++;
+			}
+			group[t].imagesValidated++;
+			group[t].timeTraining += getMilliseconds() - begin + shared;
+		}
+	}
+	for (int t = 0; t < count; t++) {
+		if (!group[t].stopped) {
+			group[t].validation = images > 0 ? 100.0f * group[t].validation / (float)images : 0.0f;
+		}
+	}
+}
+
+// measure the accuracy of every trial of a group that is still training on the validation images, stopping the training of trials that no longer improve
+void validateTrials(Trial* group, int count) {
+	measureValidation(group, count);
+	for (int t = 0; t < count; t++) {
+		if (group[t].stopped) {
+			continue;
+		}
+		if (group[t].validation >= group[t].bestValidation + earlyStoppingMargin) {
+			group[t].validationsWithoutImprovement = 0;
+		}
+		else {
+			group[t].validationsWithoutImprovement++;
+			if (group[t].validationsWithoutImprovement >= earlyStoppingPatience) {
+				group[t].stopped = 1;
+			}
+		}
+		if (group[t].validation > group[t].bestValidation) {
+			group[t].bestValidation = group[t].validation;
+		}
+	}
+}
+
+// train a group of trials on the training images before image number end, stepping all of them through the images together so each image is read
+// once; the time spent reading an image is shared equally between the trials that use it. Each trial continues after the images it has already
+// trained on, so training can be split into several calls; skipped images are stepped over without training on them
+void trainTrialGroup(Trial* group, int count, int end) {
+	char prediction = -1;
+	double begin = 0.0;
+	double shared = 0.0;
+	int active = 0;
+	int start = end;
+
+	for (int t = 0; t < count; t++) {
+		if (!group[t].stopped && group[t].imagesTrained < start) {
+			start = group[t].imagesTrained;
+		}
+	}
+
+	training = 1;
+	for (imageNumber = start; imageNumber < end; imageNumber++) {
+
+		// count the trials that use this image
+		active = 0;
+		for (int t = 0; t < count; t++) {
+			if (!group[t].stopped && group[t].imagesTrained == imageNumber) {
+				active++;
+			}
+		}
+		if (active > 0) {
+			begin = getMilliseconds();
+			readImage(imageNumber);
+			shared = (getMilliseconds() - begin) / active;
+
+			for (int t = 0; t < count; t++) {
+				if (group[t].stopped || group[t].imagesTrained != imageNumber) {
+					continue;
+				}
+				if (imageSkipped) {
+					group[t].imagesTrained++;
+					group[t].imagesSkipped++;
+					group[t].timeTraining += shared;
+					continue;
+				}
+				begin = getMilliseconds();
+				selectTrial(&group[t]);
+				prediction = classifyImage();
+				beginStage();
+				train(prediction, imageSigns[imageNumber]);
+				endStage(2);
+				group[t].imagesTrained++;
+				group[t].timeTraining += getMilliseconds() - begin + shared;
+			}
+		}
+
+		// periodically check whether each trial is still improving
+		if (earlyStopping && (imageNumber + 1) % validationInterval == 0) {
+			validateTrials(group, count);
+			training = 1;
+		}
+	}
+	training = 0;
+}
+
+// test a group of trials on the test images, reading each image once for all of them like trainTrialGroup; with batchSize above 1, the images are
+// read batchSize at a time and each trial convolves the whole batch at once. Skipped images are not classified or counted
+void testTrialGroup(Trial* group, int count) {
+	char skipped[maxBatchSize];
+	char prediction = -1;
+	double begin = 0.0;
+	double shared = 0.0;
+	double dense = 0.0;
+	int active = 0;
+	int size = batchSize < maxBatchSize ? batchSize : maxBatchSize;
+	int end = 0;
+
+	if (size < 1 || threadsUsed > 1) {
+		size = 1;
+	}
+	prepareSequentialChecks();
+	training = 0;
+	for (int first = numTraining; first < numTotal; first += size) {
+		end = first + size < numTotal ? first + size : numTotal;
+
+		// count the trials that use these images
+		active = 0;
+		for (int t = 0; t < count; t++) {
+			if (!group[t].testingStopped) {
+				active++;
+			}
+		}
+		if (active == 0) {
+			continue;
+		}
+
+		begin = getMilliseconds();
+		for (imageNumber = first; imageNumber < end; imageNumber++) {
+			readImage(imageNumber);
+			skipped[imageNumber - first] = imageSkipped;
+			if (size > 1) {
+				storeBatchImage(imageNumber - first);
+			}
+		}
+		shared = (getMilliseconds() - begin) / active;
+
+		for (int t = 0; t < count; t++) {
+			if (group[t].testingStopped) {
+				continue;
+			}
+			begin = getMilliseconds();
+			dense = 0.0;
+			selectTrial(&group[t]);
+
+			prepareTestParameters();
+			if (size > 1) {
+				convolveBatchImages(end - first);
+			}
+
+			for (imageNumber = first; imageNumber < end && !group[t].testingStopped; imageNumber++) {
+				if (skipped[imageNumber - first]) {
+					continue;
+				}
+
+				// measure classification accuracy
+				prediction = size > 1 ? classifyBatchImage(imageNumber - first) : classifyImage();
+				if (prediction == imageSigns[imageNumber]) {
+					group[t].imagesCorrect++;
+				}
+				group[t].imagesClassified++;
+				if (group[t].pruned) {
+					dense += compareDensePass();
+				}
+
+				// with sequential testing, stop at a check once the accuracy is known precisely enough or is certainly below the best finished trial's
+				if (sequentialTesting && isTestCheck(group[t].imagesClassified)) {
+					updateAccuracyInterval(&group[t]);
+					if (group[t].accuracyHigh - group[t].accuracyLow < targetIntervalWidth) {
+						group[t].testingStopped = 1;
+					}
+					else if (group[t].accuracyHigh < bestAccuracyLow) {
+						group[t].testingStopped = 2;
+					}
+				}
+			}
+			group[t].timeTesting += getMilliseconds() - begin + shared - dense;
+		}
+	}
+	imageNumber = numTotal;
+	for (int t = 0; t < count; t++) {
+		if (group[t].imagesClassified > 0) {
+			updateAccuracyInterval(&group[t]);
+			if (group[t].accuracyLow > bestAccuracyLow) {
+				bestAccuracyLow = group[t].accuracyLow;
+			}
+		}
 	}
-	for (int i = 0; i < 14; i++) {
-		P[i] = (nnOutputs[i] - min) / range;
+}
+
+// train and test a group of trials; with early stopping, the last training images are held out for validation
+void runTrialGroup(Trial* group, int count) {
+	trainTrialGroup(group, count, earlyStopping ? numTraining - numValidation : numTraining);
+	saveTrialModels(group, count);
+	testTrialGroup(group, count);
+}
+
+// trial used to time the convolution kernels
+Trial tuningTrial;
+
+// get the address of the tuning file of this computer
+void getTuningAddress(char* address, int length) {
+	char host[128] = "host";
+#ifdef _WIN32
+	if (getenv("COMPUTERNAME") != NULL) {
+		snprintf(host, sizeof(host), "%s", getenv("COMPUTERNAME"));
 	}
-	
-	float tr = 0.005f;
+#elif defined(__linux__)
+	gethostname(host, sizeof(host) - 1);
+#endif
+	snprintf(address, length, "kernels-%s.txt", host);
+}
 
-	// training the second half bias values
-	for (int i = 0; i < 14; i++) {
-		if (co == i) {
-			nnBiases2[i] -= tr * ((200.0f * P[i] - 200.0f) / range);
-		}
-		else {
-			nnBiases2[i] -= tr * (2.0f * P[i] / range);
+// choose the convolution kernel for each filter size, filter count, and number of colors in the experiment: read the choices from the tuning file of
+// this computer, and time the kernels for any without one on the first sample image, then add those choices to the file
+void chooseKernels() {
+	char address[200];
+	char line[200];
+	char name[32];
+	int size, count, colors, tunedWidth, tunedHeight;
+	int imageWidth = resizeImages ? targetWidth : 0;
+	int imageHeight = resizeImages ? targetHeight : 0;
+	FILE* fp;
+
+	// a color model with each number of colors: K grayscale, RGB, and RGBK
+	char colorModels[5] = { 0, 6, 0, 0, 1 };
+
+	for (int i = 0; i <= maxFilterSize; i++) {
+		for (int n = 0; n <= maxNumFilters; n++) {
+			for (int c = 0; c < 5; c++) {
+				kernelChoices[i][n][c] = -1;
+			}
 		}
 	}
 
-	// training the second half weight values
-	for (int i = 0; i < 14; i++) {
-		for (int j = 0; j < numFilters; j++) {
-			if (co == i) {
-				nnWeights2[i][j] -= tr * (nnHidden[j] * (200.0f * P[i] - 200.0f) / range);
+	// each line holds a filter size, filter count, number of colors, the image width and height (0 for images at their original sizes), and the
+	// kernel chosen for them
+	getTuningAddress(address, sizeof(address));
+	fopen_s(&fp, address, "r");
+	if (fp != NULL) {
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			if (sscanf(line, "%i %i %i %i %i %31s", &size, &count, &colors, &tunedWidth, &tunedHeight, name) != 6 || size < 1 || size > maxFilterSize
+				|| count < 1 || count > maxNumFilters || colors < 1 || colors > 4 || tunedWidth != imageWidth || tunedHeight != imageHeight) {
+				continue;
 			}
-			else {
-				nnWeights2[i][j] -= tr * (nnHidden[j] * 2.0f * P[i] / range);
+			for (int k = 0; k < numKernels; k++) {
+				if (strcmp(name, kernelNames[k]) == 0) {
+					kernelChoices[size][count][colors] = k;
+				}
 			}
 		}
+		fclose(fp);
 	}
 
-	// values to change the biases and weights on the first half of the neural network by; these depend on the ideal change in output values
-	float change[maxNumFilters] = { 0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,
-	0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f,0.0f };
+	float referenceInputs[maxNumFilters];
+	int referenceI[maxNumFilters];
+	int referenceJ[maxNumFilters];
+	double times[numKernels];
+	double begin = 0.0;
+	int runs = 0;
+	int best = 0;
+	char header = fp == NULL;
+	char opened = 0;
+
+	for (size = firstFilterSize; size <= lastFilterSize; size += 2) {
+		for (count = 24; count <= maxNumFilters; count += 24) {
+			for (colors = 1; colors <= 4; colors++) {
+				if (colors == 2) {
+					continue;
+				}
+				if (kernelChoices[size][count][colors] >= 0) {
+					printf("Convolution kernel for %i %ix%i filters, %i color%s: %s (from %s)\n", count, size, size, colors, colors > 1 ? "s" : "",
+						kernelNames[(int)kernelChoices[size][count][colors]], address);
+					continue;
+				}
+				if (!opened) {
+					readImage(0);
+					opened = 1;
+				}
+				startTrial(&tuningTrial, (char)size, count, colorModels[colors]);
+				convert();
+
+				best = 0;
+				for (int k = 0; k < numKernels; k++) {
+					kernel = k;
+					runs = 0;
+					begin = getMilliseconds();
+					do {
+						convolveColors();
+						runs++;
+					} while (runs < 3 || getMilliseconds() - begin < 20.0);
+					times[k] = (getMilliseconds() - begin) / runs;
+
+					// the unrolled kernels give the reference results, and a kernel giving any other maximum or position is not used
+					for (int i = 0; i < numFilters; i++) {
+						if (k == 0) {
+							referenceInputs[i] = nnInputs[i];
+							referenceI[i] = filterMapMaxI[i];
+							referenceJ[i] = filterMapMaxJ[i];
+						}
+						else if (nnInputs[i] != referenceInputs[i] || filterMapMaxI[i] != referenceI[i] || filterMapMaxJ[i] != referenceJ[i]) {
+							times[k] = -1.0;
+							break;
+						}
+					}
+					if (times[k] >= 0.0 && times[k] < times[best]) {
+						best = k;
+					}
+				}
+				kernel = 0;
+				kernelChoices[size][count][colors] = best;
 
-	// training the first half bias values
-	for (int i = 0; i < numFilters; i++) {
-		for (int j = 0; j < 14; j++) {
-			if (co == j) {
-				change[i] += ((200.0f * P[j] - 200.0f) / range) * nnWeights2[j][i];
+				printf("Convolution kernel for %i %ix%i filters, %i color%s: %s (", count, size, size, colors, colors > 1 ? "s" : "", kernelNames[best]);
+				for (int k = 0; k < numKernels; k++) {
+					if (times[k] < 0.0) {
+						printf("%s%s different results", k > 0 ? ", " : "", kernelNames[k]);
+					}
+					else {
+						printf("%s%s %fms", k > 0 ? ", " : "", kernelNames[k], times[k]);
+					}
+				}
+				printf(" per image)\n");
+
+				fopen_s(&fp, address, "a");
+				if (fp == NULL) {
+					printf("Couldn't write file %s\n", address);
+					continue;
+				}
+				if (header) {
+					fprintf(fp, "# convolution kernel chosen for each filter size, filter count, number of colors, and image width and height (0 for original sizes)\n");
+					header = 0;
+				}
+				fprintf(fp, "%i %i %i %i %i %s\n", size, count, colors, imageWidth, imageHeight, kernelNames[best]);
+				fclose(fp);
 			}
-			else {
-				change[i] += (2.0f * P[j] / range) * nnWeights2[j][i];
+		}
+	}
+	printf("\n");
+}
+
+// time the classification of single images (conversion, convolution, and the neural network) with 1, 2, 4, and so on up to numThreads threads,
+// for each filter count with the first filter size and the RGB color model, and print the median time of the first latencyImages sample images
+void measureLatency() {
+	double times[latencyImages];
+	double median = 0.0;
+	double single[4];
+	double begin = 0.0;
+
+	printf("Single image latency (median of %i images, %ix%i filters, RGB) by threads used:\n", latencyImages, firstFilterSize, firstFilterSize);
+	training = 1;
+	for (int threads = 1; threads <= numThreads; threads = threads * 2 > numThreads && threads < numThreads ? numThreads : threads * 2) {
+		threadsUsed = threads;
+		printf("%i thread%s:", threads, threads > 1 ? "s" : "");
+		for (int n = 24; n < 100; n += 24) {
+			startTrial(&tuningTrial, firstFilterSize, n, 0);
+			for (int k = 0; k < latencyImages; k++) {
+				readImage(k);
+				begin = getMilliseconds();
+				classifyImage();
+				times[k] = getMilliseconds() - begin;
+			}
+
+			// sort the times to find the median
+			for (int k = 1; k < latencyImages; k++) {
+				for (int l = k; l > 0 && times[l] < times[l - 1]; l--) {
+					median = times[l];
+					times[l] = times[l - 1];
+					times[l - 1] = median;
+				}
 			}
+			median = times[latencyImages / 2];
+			if (threads == 1) {
+				single[n / 24 - 1] = median;
+			}
+			printf("%s %i filters %fms (%.2fx)", n > 24 ? "," : "", n, median, single[n / 24 - 1] / median);
 		}
-		nnBiases1[i] -= tr * change[i];
+		printf("\n");
 	}
+	training = 0;
+	threadsUsed = numThreads;
+	printf("\n");
+}
 
-	// training the first half weight values
-	for (int h = 0; h < numFilters; h++) {
-		for (int i = 0; i < numFilters; i++) {
-			nnWeights1[h][i] -= tr * change[h] * nnInputs[i];
+// time the conversion, convolution, and neural network of the first throughputImages test images in batches of 1, 2, 4, and so on up to
+// maxBatchSize, on one thread, for each filter size with 96 filters and the RGB color model, and print the images classified per second in the
+// fastest of 3 passes
+void measureBatchThroughput() {
+	double single = 0.0;
+	double time = 0.0;
+	double fastest = 0.0;
+	double begin = 0.0;
+	int end = 0;
+
+	printf("Test image throughput (%i images, 96 filters, RGB) by batch size:\n", throughputImages);
+	threadsUsed = 1;
+	for (char size = firstFilterSize; size <= lastFilterSize; size += 2) {
+		printf("%ix%i:", size, size);
+		for (int count = 1; count <= maxBatchSize; count *= 2) {
+			// the inputs are normalized as in testing, after one training image
+			startTrial(&tuningTrial, size, 96, 0);
+			tuningTrial.imagesTrained = 1;
+			fastest = 0.0;
+			for (int pass = 0; pass < 3; pass++) {
+				time = 0.0;
+				for (int first = numTraining; first < numTraining + throughputImages; first += count) {
+					end = first + count;
+					for (int n = first; n < end; n++) {
+						readImage(n);
+						if (count > 1) {
+							storeBatchImage(n - first);
+						}
+					}
+					begin = getMilliseconds();
+					if (count > 1) {
+						convolveBatchImages(count);
+						for (int k = 0; k < count; k++) {
+							classifyBatchImage(k);
+						}
+					}
+					else {
+						classifyImage();
+					}
+					time += getMilliseconds() - begin;
+				}
+				if (pass == 0 || time < fastest) {
+					fastest = time;
+				}
+			}
+			if (count == 1) {
+				single = fastest;
+			}
+			printf("%s %i: %.1f images/s (%.2fx)", count > 1 ? "," : "", count, 1000.0 * throughputImages / fastest, single / fastest);
 		}
+		printf("\n");
 	}
+	threadsUsed = numThreads;
+	printf("\n");
 }
 
-// function used to test getRand
-void testRand() {
-	printf("100 random integers from 0 to 99:\n");
-	for (int i = 0; i < 100; i++) {
-		printf("%i ", randInt(0, 100));
+// trials of the successive halving search, used to rank them
+Trial* searchTrials = NULL;
+
+// order of the successive halving results: the tested trials by test accuracy, then the others by the last round they took part in and their
+// validation accuracy
+int compareSearchTrials(const void* a, const void* b) {
+	Trial* x = &searchTrials[*(const int*)a];
+	Trial* y = &searchTrials[*(const int*)b];
+	int roundX = x->eliminated == 0 ? 1000000 : x->eliminated;
+	int roundY = y->eliminated == 0 ? 1000000 : y->eliminated;
+	if (roundX != roundY) {
+		return roundY - roundX;
 	}
-	printf("\n\n100 random decimals from -50 to 50:\n");
-	for (int i = 0; i < 100; i++) {
-		printf("%f ", randFloat(-50.0f, 100.0f));
+	float accuracyX = x->eliminated == 0 ? (float)x->imagesCorrect / (float)x->imagesClassified : x->validation;
+	float accuracyY = y->eliminated == 0 ? (float)y->imagesCorrect / (float)y->imagesClassified : y->validation;
+	if (accuracyX != accuracyY) {
+		return accuracyX < accuracyY ? 1 : -1;
 	}
-	printf("\n\n");
+	return *(const int*)a - *(const int*)b;
 }
 
-// function used to test getAddress
-void testAddressConstructor() {
-	for (int i = 1; i < 13; i++) {
-		for (int j = 1; j <= 5; j++) {
-			printf("%s\n", getAddress(i, j, 7, 234));
-		}
+// order of the trials still in the successive halving search by validation accuracy, most accurate first
+int compareValidations(const void* a, const void* b) {
+	Trial* x = &searchTrials[*(const int*)a];
+	Trial* y = &searchTrials[*(const int*)b];
+	if (x->validation != y->validation) {
+		return x->validation < y->validation ? 1 : -1;
 	}
+	return *(const int*)a - *(const int*)b;
 }
 
-// function used to test whether the number of images of each sign type in each folder is as in imageCounts
-void testNumImages() {
-
-	FILE* f;
+#define checkpointSettings 18
+
+// fill the first checkpointSettings values of a checkpoint header with the settings the stored trials depend on: the sample, the trial count and
+// size, the search budget and rate, the validation images and early stopping, the trial groups, the filter sizes swept, the parameter precision and
+// pruning, and the image selection, resizing, and early stopping split as in model files
+void getCheckpointSettings(int* header, int count) {
+	int settings[modelHeaderSize];
+	getModelSettings(settings, 0, 0, 0);
+	header[0] = numTotal;
+	header[1] = count;
+	header[2] = (int)sizeof(Trial);
+	header[3] = (int)baseSeed;
+	header[4] = halvingBudget;
+	header[5] = halvingRate;
+	header[6] = numValidation;
+	header[7] = earlyStopping;
+	header[8] = trialGroups;
+	header[9] = firstFilterSize;
+	header[10] = lastFilterSize;
+	header[11] = parameterPrecision;
+	memcpy(&header[12], &pruneFraction, sizeof(int));
+	memcpy(&header[13], &settings[8], 5 * sizeof(int));
+}
 
-	int numChallengeLevels = 5;
-	int n = 0;
-	int challengeIndex = 0;
+// save the state of the successive halving search after a round: the settings it depends on, the next round, its training budget, and every trial
+void writeCheckpoint(Trial* group, int count, int rung, int budget, int left) {
+	int header[checkpointSettings + 2];
+	FILE* fp;
+	fopen_s(&fp, halvingCheckpoint, "wb");
+	if (fp == NULL) {
+		printf("Couldn't write file %s\n", halvingCheckpoint);
+		return;
+	}
+	getCheckpointSettings(header, count);
+	header[checkpointSettings] = rung;
+	header[checkpointSettings + 1] = budget;
+	fwrite(header, sizeof(int), checkpointSettings + 2, fp);
+	fwrite(&left, sizeof(int), 1, fp);
+	fwrite(group, sizeof(Trial), count, fp);
+	fclose(fp);
+}
 
-	int l = 0;
+// resume the successive halving search from its checkpoint, if there is one saved with the same settings; returns the round to continue with, or 0
+int readCheckpoint(Trial* group, int count, int* budget, int* left) {
+	int header[checkpointSettings + 2];
+	int expected[checkpointSettings];
+	FILE* fp;
+	fopen_s(&fp, halvingCheckpoint, "rb");
+	if (fp == NULL) {
+		return 0;
+	}
+	getCheckpointSettings(expected, count);
+	if (fread(header, sizeof(int), checkpointSettings + 2, fp) != checkpointSettings + 2 || memcmp(header, expected, sizeof(expected)) != 0) {
+		printf("%s was saved with other settings and is not used\n\n", halvingCheckpoint);
+		fclose(fp);
+		return 0;
+	}
+	if (fread(left, sizeof(int), 1, fp) != 1 || fread(group, sizeof(Trial), count, fp) != (size_t)count) {
+		printf("%s is incomplete and is not used\n\n", halvingCheckpoint);
+		fclose(fp);
+		return 0;
+	}
+	fclose(fp);
+	*budget = header[checkpointSettings + 1];
+	printf("Resuming from round %i of successive halving (%s)\n\n", header[checkpointSettings], halvingCheckpoint);
+	return header[checkpointSettings];
+}
 
-	char err = 0;
+// search the experiment's configurations by successive halving (see successiveHalving), then print the results of the trials that were tested,
+// every trial ranked, and the compute spent compared with running every trial to completion
+void runSearch() {
+	int trainingEnd = numTraining - numValidation;
+	int count = 0;
+	int rung = 1;
+	int budget = halvingBudget;
+	int left = 0;
+	int keep = 0;
+	int order[numConfigurations];
+
+	searchTrials = (Trial*)malloc(sizeof(Trial) * numConfigurations);
+	if (searchTrials == NULL) {
+		printf("Not enough memory for %i trials\n", numConfigurations);
+		return;
+	}
+	Trial* group = searchTrials;
 
-	// visual conditions
-	for (int i = 0; i < 13; i++) {
-		if (i == 0) {
-			numChallengeLevels = 1;
-		}
-		else {
-			numChallengeLevels = 5;
+	for (char size = firstFilterSize; size <= lastFilterSize; size += 2) {
+		for (int n = 24; n < 100; n += 24) {
+			for (char c = 0; c < 8; c++) {
+				startTrial(&group[count], size, n, c);
+				count++;
+			}
 		}
+	}
+	left = count;
 
-		// challenge levels
-		for (int j = 1; j <= numChallengeLevels; j++) {
+	if (halvingCheckpoints) {
+		int resumed = readCheckpoint(group, count, &budget, &left);
+		if (resumed > 0) {
+			rung = resumed;
+		}
+	}
 
-			// sign types
-			for (int k = 1; k < 15; k++) {
+	while (1) {
+		// the last round trains the trials left on every training image
+		if (budget >= trainingEnd || left <= 1) {
+			budget = trainingEnd;
+		}
+		trainTrialGroup(group, count, budget);
+		if (budget == trainingEnd) {
+			break;
+		}
 
-				l = imageCounts[k - 1]; 
-				fopen_s(&f, getAddress(i, j, k, l), "rb");
-				if (f == NULL) {
-					printf("File %s is NULL - %i %i %i %i\n", getAddress(i, j, k, l), i, j, k, l);
-					err = 1;
-					break;
-				}
-				else {
-					fclose(f);
-				}
+		// keep the most accurate trials on the validation images
+		measureValidation(group, count);
+		left = 0;
+		for (int t = 0; t < count; t++) {
+			if (group[t].eliminated == 0) {
+				order[left] = t;
+				left++;
 			}
 		}
+		qsort(order, left, sizeof(int), compareValidations);
+		keep = (left + halvingRate - 1) / halvingRate;
+		for (int k = keep; k < left; k++) {
+			group[order[k]].eliminated = rung;
+			group[order[k]].stopped = 1;
+			group[order[k]].testingStopped = 3;
+		}
+		printf("Round %i: %i trials trained on %i images, validation accuracy %f%% to %f%%, %i kept\n", rung, left, budget,
+		group[order[left - 1]].validation, group[order[0]].validation, keep);
+
+		left = keep;
+		budget *= halvingRate;
+		rung++;
+		if (halvingCheckpoints) {
+			writeCheckpoint(group, count, rung, budget, left);
+		}
 	}
-	if (!err) {
-		printf("All folders contain the needed images.\n");
+	printf("Round %i: %i trials trained on %i images and tested\n\n", rung, left, budget);
+	saveTrialModels(group, count);
+	testTrialGroup(group, count);
+
+	for (int t = 0; t < count; t++) {
+		if (group[t].eliminated == 0) {
+			printResults(&group[t]);
+		}
+	}
+
+	// rank every trial
+	for (int t = 0; t < count; t++) {
+		order[t] = t;
+	}
+	qsort(order, count, sizeof(int), compareSearchTrials);
+	printf("Ranking:\n");
+	long long passes = 0;
+	double spent = 0.0;
+	double fullTime = 0.0;
+	for (int k = 0; k < count; k++) {
+		Trial* t = &group[order[k]];
+		printf("%i. %i Filters of Size %ix%i, Color Model #%i: trained on %i images, validation %f%%, ", k + 1, t->numFilters, t->filterSize, t->filterSize,
+		t->colorModel + 1, t->imagesTrained, t->validation);
+		if (t->eliminated == 0) {
+			printf("test %f%% on %i images\n", 100.0f * (float)t->imagesCorrect / (float)t->imagesClassified, t->imagesClassified);
+		}
+		else {
+			printf("left out after round %i\n", t->eliminated);
+		}
+
+		// the full grid time of each trial is estimated from its average time per image
+		int images = t->imagesTrained + t->imagesValidated + t->imagesClassified;
+		passes += images;
+		spent += t->timeTraining + t->timeTesting;
+		fullTime += (t->timeTraining + t->timeTesting) / images * numTotal;
 	}
+	printf("Compute: %lld images classified in %i rounds, %f%% of the %lld for every trial on every image; %ims, about %f%% of the %ims estimated for "
+		"every trial\n\n", passes, rung, 100.0 * (double)passes / ((double)count * numTotal), (long long)count * numTotal, (int)(spent + 0.5),
+		100.0 * spent / fullTime, (int)(fullTime + 0.5));
+
+	free(searchTrials);
+	searchTrials = NULL;
 }
 
-// function used to test the image randomizer
-void testRandomImages() {
-	initializeImagesAll();
-	for (int i = 0; i < numTotal; i++) {
-		printf("Image %i: Condition %i, Challenge Level %i, Sign Type %i, Sign Number %i\n", i, imageConditions[i], imageChallenges[i], imageSigns[i], imageNumbers[i]);
+// test accuracy (%) of each configuration in resultsFile for this sample, by trial number, and the number of images it was trained on; -1 for
+// configurations without results
+float resultAccuracies[numConfigurations];
+int resultImagesTrained[numConfigurations];
+
+// read the test accuracy of each configuration from resultsFile, keeping the last line of each that was run with the same sample, parameterPrecision,
+// pruneFraction, image selection, resizing, and early stopping split, so it describes the model that is timed; lines without these settings are
+// skipped. Returns the number of configurations found
+int readResults() {
+	char line[512];
+	int size, count, colorModel, correct, classified, memory, trained, warm, precision, total;
+	int settings[5];
+	int expected[modelHeaderSize];
+	float accuracy, prune;
+	double training, testing;
+	unsigned int seed;
+	int found = 0;
+	int number = 0;
+	FILE* fp;
+
+	for (int k = 0; k < numConfigurations; k++) {
+		resultAccuracies[k] = -1.0f;
+		resultImagesTrained[k] = -1;
+	}
+	fopen_s(&fp, resultsFile, "r");
+	if (fp == NULL) {
+		return 0;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%i,%i,%i,%i,%i,%f,%lf,%lf,%i,%i,%i,%i,%f,%i,%u,%i,%i,%i,%i,%i", &size, &count, &colorModel, &correct, &classified, &accuracy,
+			&training, &testing, &memory, &trained, &warm, &precision, &prune, &total, &seed, &settings[0], &settings[1], &settings[2], &settings[3],
+			&settings[4]) != 20) {
+			continue;
+		}
+		getModelSettings(expected, 0, 0, 0);
+		if (total != numTotal || seed != baseSeed || size < firstFilterSize || size > lastFilterSize || size % 2 == 0 || count % 24 != 0 ||
+			count < 24 || count > 96 || colorModel < 1 || colorModel > 8 || precision != parameterPrecision || fabsf(prune - pruneFraction) > 0.000001f
+			|| memcmp(settings, &expected[8], sizeof(settings)) != 0) {
+			continue;
+		}
+		filterSize = (char)size;
+		numFilters = count;
+		currentColorModel = (char)(colorModel - 1);
+		number = getTrialNumber();
+		if (resultAccuracies[number] < 0.0f) {
+			found++;
+		}
+		resultAccuracies[number] = accuracy;
+		resultImagesTrained[number] = trained;
 	}
+	fclose(fp);
+	return found;
 }
 
-// function used to test reading an image file and printing the pixel color values
-void testFileReading() {
+// order of times, shortest first
+int compareTimes(const void* a, const void* b) {
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return x < y ? -1 : x > y;
+}
 
-	readFile("C:\\Train\\Darkening-1\\01_11_04_01_0052.bmp");
+// get percentile p of count sorted times: the shortest time that at least p% of the times are within
+double getPercentile(double* times, int count, double p) {
+	int k = (int)ceil(p / 100.0 * count) - 1;
+	return times[k < 0 ? 0 : k];
+}
 
-	printf("Inner Width: %i, Inner Height: %i, Line Length: %i\n\n", innerWidth, innerHeight, lineLength);
+// choose the model to serve (see selectModel): try the configurations with results and saved models from the most accurate down, timing each
+// classification of the benchmark images from reading the image to the prediction after an untimed pass over them, and write the first that meets
+// the budgets with its latency distribution. Each model is tested with its parameters pruned and stored as set by pruneFraction and parameterPrecision,
+// like the trials its results come from, and skipped images are not timed
+void selectServingModel() {
+	int order[numConfigurations];
+	int count = 0;
+	int images = numTotal - numTraining < selectionImages ? numTotal - numTraining : selectionImages;
+	double times[selectionImages];
+	double begin = 0.0;
+	double total = 0.0;
+	int correct = 0;
+	int timed = 0;
+	int k = 0;
+	Trial* t = &trials[0];
+	Trial* chosen = NULL;
+	FILE* fp;
 
-	printf("\n\nBGR from left to right, bottom to top:\n\n");
+	if (readResults() == 0) {
+		printf("No results for this sample in %s; run the trials with saveResults and saveModels set first\n\n", resultsFile);
+		return;
+	}
+	for (int number = 0; number < numConfigurations; number++) {
+		if (resultAccuracies[number] >= 0.0f) {
+			order[count] = number;
+			count++;
+		}
+	}
 
-	for (int h = 0; h < innerHeight; h++) {
-		for (int i = 0; i < lineLength; i++) {
-			printf("%i ", file[h * lineLength + i + 54]);
+	// most accurate first; the sort keeps the order of the configurations for equal accuracies
+	for (int a = 1; a < count; a++) {
+		for (int b = a; b > 0 && resultAccuracies[order[b]] > resultAccuracies[order[b - 1]]; b--) {
+			k = order[b];
+			order[b] = order[b - 1];
+			order[b - 1] = k;
 		}
-		printf("\n");
 	}
-}
 
-// function used to test convert
-void testConversions() {
-	r[0] = 0; g[0] = 20; b[0] = 20;
-	r[1] = 40; g[1] = 20; b[1] = 20;
-	r[2] = 60; g[2] = 0; b[2] = 20;
-	r[3] = 200; g[3] = 80; b[3] = 80;
-	r[4] = 80; g[4] = 80; b[4] = 150;
-	r[5] = 255; g[5] = 20; b[5] = 255;
-	r[6] = 0; g[6] = 90; b[6] = 0;
-	r[7] = 0; g[7] = 0; b[7] = 0;
-	r[8] = 129; g[8] = 255; b[8] = 183;
+	printf("Choosing the most accurate of %i configurations within %fms per image (99th percentile of %i test images) and %i bytes:\n", count,
+		latencyBudget, images, memoryBudget);
+	training = 0;
+	for (int c = 0; c < count && chosen == NULL; c++) {
+		char size = (char)(order[c] / 32 * 2 + firstFilterSize);
+		int filters = (order[c] / 8 % 4 + 1) * 24;
+		char colorModel = (char)(order[c] % 8);
+		printf("%i Filters of Size %ix%i, Color Model #%i (%f%%): ", filters, size, size, colorModel + 1, resultAccuracies[order[c]]);
+
+		startTrial(t, size, filters, colorModel);
+		if (!loadModel(t, size, filters, colorModel)) {
+			printf("no saved model\n");
+			continue;
+		}
+		if (t->imagesTrained != resultImagesTrained[order[c]]) {
+			printf("saved model trained on %i images, not the %i of its results\n", t->imagesTrained, resultImagesTrained[order[c]]);
+			continue;
+		}
+		selectTrial(t);
+		prepareTestParameters();
+		if (t->memoryUsage > memoryBudget) {
+			printf("%i bytes, over the memory budget\n", t->memoryUsage);
+			continue;
+		}
 
-	height = 3;
-	width = 3;
-	printf("Nine example colors converted to eight color models:\n\n");
-	for (char i = 0; i < 8; i++) {
-		currentColorModel = i;
-		convert();
-		for (int i = 0; i < 9; i++) {
-			printf("R %i, G %i, B %i, C1 %i, C2 %i, C3 %i, C4 %i\n", r[i], g[i], b[i], c1[i], c2[i], c3[i], c4[i]);
+		// classify the images once untimed, so every candidate is timed with the image files and its parameters already in the caches
+		for (int n = 0; n < images; n++) {
+			readImage(numTraining + n);
+			if (!imageSkipped) {
+				classifyImage();
+			}
 		}
-		printf("\n\n");
+
+		// time every image from reading it to the prediction
+		correct = 0;
+		timed = 0;
+		total = 0.0;
+		for (int n = 0; n < images; n++) {
+			begin = getMilliseconds();
+			readImage(numTraining + n);
+			if (imageSkipped) {
+				continue;
+			}
+			char prediction = classifyImage();
+			times[timed] = getMilliseconds() - begin;
+			total += times[timed];
+			timed++;
+			if (prediction == imageSigns[numTraining + n]) {
+				correct++;
+			}
+		}
+		if (timed == 0) {
+			printf("no images to time\n");
+			continue;
+		}
+		qsort(times, timed, sizeof(double), compareTimes);
+		printf("p50 %fms, p99 %fms, %i bytes, %f%% of the timed images correct%s\n", getPercentile(times, timed, 50.0),
+			getPercentile(times, timed, 99.0), t->memoryUsage, 100.0f * (float)correct / (float)timed,
+			getPercentile(times, timed, 99.0) > latencyBudget ? ", over the latency budget" : "");
+		if (getPercentile(times, timed, 99.0) <= latencyBudget) {
+			chosen = t;
+		}
+	}
+	if (chosen == NULL) {
+		printf("No configuration meets the budgets\n\n");
+		return;
+	}
+
+	// the model to serve, with its 32-bit parameters read again since 16-bit storage writes over them, and a report of how it was chosen
+	if (chosen->stored) {
+		loadModel(chosen, chosen->filterSize, chosen->numFilters, chosen->colorModel);
+	}
+	writeModel(chosen, servingModel);
+	fopen_s(&fp, servingReport, "w");
+	if (fp == NULL) {
+		printf("Couldn't write file %s\n", servingReport);
+		return;
 	}
+	fprintf(fp, "Model: %s\nConfiguration: %i filters of size %ix%i, color model #%i\nTest Accuracy: %f%% (%s)\n", servingModel, chosen->numFilters,
+		chosen->filterSize, chosen->filterSize, chosen->colorModel + 1, resultAccuracies[getTrialNumber()], resultsFile);
+	fprintf(fp, "Trained On: %i images%s (%i with the models it started from)\nMemory Usage: %i bytes (budget %i)\n", chosen->imagesTrained,
+		chosen->warmStartFilters > 0 ? ", after a warm start" : "", chosen->imagesTrained + chosen->warmStartChain, chosen->memoryUsage, memoryBudget);
+	fprintf(fp, "Timed Parameters: %s, %f%% of the weights pruned (the model file holds the 32-bit parameters)\n", precisionNames[(int)parameterPrecision],
+		100.0f * pruneFraction);
+	fprintf(fp, "Latency Budget: %fms per image at the 99th percentile\nTimed Images: %i (reading, conversion, convolution, and neural network)\n",
+		latencyBudget, timed);
+	fprintf(fp, "Latency: mean %fms, min %fms, p50 %fms, p90 %fms, p95 %fms, p99 %fms, max %fms\n", total / timed, times[0],
+		getPercentile(times, timed, 50.0), getPercentile(times, timed, 90.0), getPercentile(times, timed, 95.0), getPercentile(times, timed, 99.0),
+		times[timed - 1]);
+	fprintf(fp, "Threads: %i, Kernel: %s, Random Seed: %u\n", threadsUsed, kernelNames[(int)kernel], baseSeed);
+	fclose(fp);
+	printf("Serving %i Filters of Size %ix%i, Color Model #%i: written to %s, latency distribution in %s\n\n", chosen->numFilters, chosen->filterSize,
+		chosen->filterSize, chosen->colorModel + 1, servingModel, servingReport);
 }
 
 // runs the entire experimental process: 5 filter sizes * 4 filter counts * 8 color models = 160 trials 
 void runTest() {
-	char prediction = -1;
+	int count = 0;
 
 	printf("Starting tests...\nEach test may take a few minutes to run.\nTest results will be displayed after each test concludes.\n\n");
+	bestAccuracyLow = 0.0f;
 
-	for (filterSize = 3; filterSize < 12; filterSize += 2) {
-
-		filterArea = filterSize * filterSize;
-		halfFilterArea = filterArea / 2;
-		padding = filterSize / 2;
-		doublePadding = padding * 2;
-
-		for (numFilters = 24; numFilters < 100; numFilters += 24) {
-
-			for (currentColorModel = 0; currentColorModel < 8; currentColorModel++) {
-				imagesCorrect = 0;
-				imagesClassified = 0;
-				randomizeParameters();
-
-				numFiltersPerColor = numFilters / getNumColors();
-				
-				memoryUsage = 4 * (numFilters * filterArea + numFilters * (numFilters + 14 + 3) + (2 * 14)) + (3 + getNumColors()) * maxImageSize + maxFileSize;
-
-				start = (int)clock();
-
-				// classify all images
-				for (imageNumber = 0; imageNumber < numTotal; imageNumber++) {
+	if (readArchives) {
+		indexArchives();
+	}
+	if (numThreads > 1) {
+		startThreads();
+	}
+	if (tuneKernels) {
+		chooseKernels();
+	}
+	if (reportLatency) {
+		measureLatency();
+	}
+	if (reportBatchThroughput) {
+		measureBatchThroughput();
+	}
+	if (selectModel) {
+		selectServingModel();
+		return;
+	}
 
-					// get address of image, read all file content and store image pixel color data
-					readFile(getAddress(imageConditions[imageNumber], imageChallenges[imageNumber], imageSigns[imageNumber], imageNumbers[imageNumber]));
-					// convert image pixel color data to this trial's color model
-					convert();
-					// convolve the image pixels
-					convolve();
-					// use the neural network to compute the classification prediction
-					prediction = computeNN();
+	if (successiveHalving) {
+		runSearch();
+		printf("All tests have finished.\n\n");
+		return;
+	}
 
-					// if in the training phase, train the algorithm
-					if (imageNumber < numTraining) {
-						train(prediction, imageSigns[imageNumber]);
-					}
-					else {
-						// otherwise, measure classification accuracy
-						if (imageNumber == numTraining) {
-							stop = (int)clock();
-							timeTraining = stop - start;
-							start = stop;
-						}
-						if (prediction == imageSigns[imageNumber]) {
-							imagesCorrect++;
-						}
-						imagesClassified++;
-					}
+	if (trialGroups == 2) {
+		// run every filter size and color model of each filter count together
+		for (int n = 24; n < 100; n += 24) {
+			count = 0;
+			for (char size = firstFilterSize; size <= lastFilterSize; size += 2) {
+				for (char c = 0; c < 8; c++) {
+					startTrial(&trials[count], size, n, c);
+					count++;
 				}
-				stop = (int)clock();
+			}
+			runTrialGroup(trials, count);
+			for (int t = 0; t < count; t++) {
+				printResults(&trials[t]);
+			}
+		}
+		printf("All tests have finished.\n\n");
+		return;
+	}
 
-				// display testing results
-				timeTesting = stop - start;
-				timeTotal = timeTraining + timeTesting;
-				printf("%i Filters of Size %ix%i, Color Model #%i: %i/%i (%f%%)\nTraining Duration: %ims\nTesting Duration: %ims\nTotal Duration: %ims (%fms per image)\nTotal Memory Usage: %i bytes\n\n",
-				numFilters, filterSize, filterSize, currentColorModel + 1, imagesCorrect, imagesClassified, 100.0f * (float)imagesCorrect / (float)imagesClassified, timeTraining, timeTesting, timeTotal, ((float)timeTotal) / (float)numTotal, memoryUsage);
+	for (char size = firstFilterSize; size <= lastFilterSize; size += 2) {
+		for (int n = 24; n < 100; n += 24) {
+			if (trialGroups == 1) {
+				// run the 8 color models together
+				for (int c = 0; c < 8; c++) {
+					startTrial(&trials[c], size, n, c);
+				}
+				runTrialGroup(trials, 8);
+				for (int c = 0; c < 8; c++) {
+					printResults(&trials[c]);
+				}
+			}
+			else {
+				for (char c = 0; c < 8; c++) {
+					startTrial(&trials[0], size, n, c);
+					runTrialGroup(trials, 1);
+					printResults(&trials[0]);
+				}
 			}
 		}
 	}
@@ -1086,13 +4571,20 @@ void runTest() {
 int main(void) {
 
 	setup();
+	readImageCounts();
 
 	//testRand();
 	//testAddressConstructor();
 	//testNumImages();
 	//testRandomImages();
 	//testFileReading();
+	//testArchiveReading();
 	//testConversions();
+	//testResize();
+	//testConvolution();
+	//testParameterPrecision();
+	//testPruning();
+	//testWarmStart();
 
 	initializeImagesChallengeFree();
 	//initializeImagesLowChallenge();